@@ -0,0 +1,126 @@
+// Counting replacements of the global operator new and delete.
+//
+// Only compiled into executables built with the GDQT_ALLOC_STATS CMake option. Sizes of freed
+// blocks are taken from the C runtime, so the live byte count includes allocator rounding.
+// Over-aligned allocations keep the runtime's own operators and are not counted, and on
+// Windows neither are allocations made inside the Qt DLLs.
+
+#include "alloc_stats.h"
+
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#  include <malloc.h>
+#  define GDQT_BLOCK_SIZE(ptr) _msize(ptr)
+#elif defined(__APPLE__)
+#  include <malloc/malloc.h>
+#  define GDQT_BLOCK_SIZE(ptr) malloc_size(ptr)
+#else
+#  include <malloc.h>
+#  define GDQT_BLOCK_SIZE(ptr) malloc_usable_size(ptr)
+#endif
+
+namespace
+{
+    // Tells AllocStats::isAvailable that this executable counts its allocations
+    [[maybe_unused]] const bool hooksRegistered = [] {
+        AllocStats::hooksInstalled.store(true, std::memory_order_relaxed);
+        return true;
+    }();
+
+    void* countedAlloc(std::size_t size) noexcept
+    {
+        void* ptr = std::malloc(size ? size : 1);
+        if (!ptr)
+            return nullptr;
+
+        qint64 blockSize = qint64(GDQT_BLOCK_SIZE(ptr));
+
+        AllocStats::allocations.fetch_add(1, std::memory_order_relaxed);
+        AllocStats::bytesAllocated.fetch_add(quint64(size), std::memory_order_relaxed);
+        qint64 live = AllocStats::liveBytes.fetch_add(blockSize, std::memory_order_relaxed) + blockSize;
+
+        // Raise the peak if this allocation set a new high
+        qint64 peak = AllocStats::peakLiveBytes.load(std::memory_order_relaxed);
+        while (live > peak && !AllocStats::peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+
+        return ptr;
+    }
+
+    void countedFree(void* ptr) noexcept
+    {
+        if (!ptr)
+            return;
+
+        AllocStats::deallocations.fetch_add(1, std::memory_order_relaxed);
+        AllocStats::liveBytes.fetch_sub(qint64(GDQT_BLOCK_SIZE(ptr)), std::memory_order_relaxed);
+
+        std::free(ptr);
+    }
+
+    void* throwingAlloc(std::size_t size)
+    {
+        // Give the new-handler a chance to release memory, as the standard operator does
+        for (;;) {
+            if (void* ptr = countedAlloc(size))
+                return ptr;
+
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    return throwingAlloc(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return throwingAlloc(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    countedFree(ptr);
+}
@@ -0,0 +1,190 @@
+#include "alloc_stats.h"
+
+#include <QDebug>
+#include <QFile>
+
+#if defined(Q_OS_WIN)
+#  ifndef PSAPI_VERSION
+#    define PSAPI_VERSION 2   // GetProcessMemoryInfo resolves to the kernel32 export, no psapi.lib needed
+#  endif
+#  define NOMINMAX
+#  include <windows.h>
+#  include <psapi.h>
+#elif defined(Q_OS_MACOS)
+#  include <mach/mach.h>
+#  include <sys/resource.h>
+#elif defined(Q_OS_UNIX)
+#  include <unistd.h>
+#endif
+
+std::atomic<quint64> AllocStats::allocations{0};
+std::atomic<quint64> AllocStats::deallocations{0};
+std::atomic<quint64> AllocStats::bytesAllocated{0};
+std::atomic<qint64> AllocStats::liveBytes{0};
+std::atomic<qint64> AllocStats::peakLiveBytes{0};
+std::atomic<bool> AllocStats::hooksInstalled{false};
+
+namespace
+{
+    QString formatBytes(qint64 bytes)
+    {
+        if (qAbs(bytes) < 1024)
+            return QString("%1 B").arg(bytes);
+        if (qAbs(bytes) < 1024 * 1024)
+            return QString("%1 KiB").arg(bytes / 1024.0, 0, 'f', 1);
+        return QString("%1 MiB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+
+#if defined(Q_OS_LINUX)
+    // Reads a "Name:   1234 kB" line from /proc/self/status
+    qint64 readProcStatus(const QByteArray& field)
+    {
+        QFile status("/proc/self/status");
+        if (!status.open(QIODevice::ReadOnly))
+            return -1;
+
+        const QList<QByteArray> lines = status.readAll().split('\n');
+        for (const QByteArray& line : lines) {
+            if (line.startsWith(field)) {
+                QByteArray value = line.mid(field.size()).trimmed();
+                value.chop(3); // " kB"
+                return value.trimmed().toLongLong() * 1024;
+            }
+        }
+
+        return -1;
+    }
+#endif
+}
+
+bool AllocStats::isAvailable()
+{
+    // Decided per executable by whether it links alloc_hooks.cpp, not by how gdqt_core was compiled
+    return hooksInstalled.load(std::memory_order_relaxed);
+}
+
+AllocStats::Snapshot AllocStats::snapshot()
+{
+    Snapshot s;
+    s.allocations = allocations.load(std::memory_order_relaxed);
+    s.deallocations = deallocations.load(std::memory_order_relaxed);
+    s.bytesAllocated = bytesAllocated.load(std::memory_order_relaxed);
+    s.liveBytes = liveBytes.load(std::memory_order_relaxed);
+
+    // Reading the RSS may allocate, so it comes after the counters
+    s.rssBytes = currentRss();
+    return s;
+}
+
+qint64 AllocStats::currentRss()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.WorkingSetSize);
+    return -1;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+        return qint64(info.resident_size);
+    return -1;
+#elif defined(Q_OS_LINUX)
+    // The second field of statm is the number of resident pages
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+qint64 AllocStats::peakRss()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.PeakWorkingSetSize);
+    return -1;
+#elif defined(Q_OS_MACOS)
+    // ru_maxrss is in bytes on macOS
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return qint64(usage.ru_maxrss);
+    return -1;
+#elif defined(Q_OS_LINUX)
+    return readProcStatus("VmHWM:");
+#else
+    return -1;
+#endif
+}
+
+QString AllocStats::describe(const Delta& delta)
+{
+    return QString("%1 allocations (%2), %3 frees, live %4%5, peak +%6, RSS %7%8")
+        .arg(delta.allocations)
+        .arg(formatBytes(qint64(delta.bytesAllocated)))
+        .arg(delta.deallocations)
+        .arg(delta.liveBytes >= 0 ? "+" : "")
+        .arg(formatBytes(delta.liveBytes))
+        .arg(formatBytes(delta.peakLiveBytes))
+        .arg(delta.rssBytes >= 0 ? "+" : "")
+        .arg(formatBytes(delta.rssBytes));
+}
+
+AllocScope::AllocScope(const char* name, bool log)
+    : name(name)
+    , active(AllocStats::isAvailable())
+    , log(log)
+{
+    if (!active)
+        return;
+
+    // Sample the RSS before the counters, so reading it is not charged to the operation
+    qint64 rss = AllocStats::currentRss();
+    start = AllocStats::snapshot();
+    start.rssBytes = rss;
+
+    // Restart the peak at the current live size; the enclosing scope's peak is restored at the end
+    outerPeak = AllocStats::peakLiveBytes.exchange(start.liveBytes, std::memory_order_relaxed);
+}
+
+AllocScope::~AllocScope()
+{
+    if (!active)
+        return;
+
+    AllocStats::Delta result = delta();
+
+    // Let the enclosing scope see the peak reached inside this one
+    qint64 innerPeak = AllocStats::peakLiveBytes.load(std::memory_order_relaxed);
+    AllocStats::peakLiveBytes.store(qMax(outerPeak, innerPeak), std::memory_order_relaxed);
+
+    if (log)
+        qDebug().noquote() << QString("Memory [%1]: %2").arg(QString::fromLatin1(name), AllocStats::describe(result));
+}
+
+AllocStats::Delta AllocScope::delta() const
+{
+    AllocStats::Delta d;
+    if (!active)
+        return d;
+
+    AllocStats::Snapshot now = AllocStats::snapshot();
+
+    d.allocations = now.allocations - start.allocations;
+    d.deallocations = now.deallocations - start.deallocations;
+    d.bytesAllocated = now.bytesAllocated - start.bytesAllocated;
+    d.liveBytes = now.liveBytes - start.liveBytes;
+    d.peakLiveBytes = AllocStats::peakLiveBytes.load(std::memory_order_relaxed) - start.liveBytes;
+    if (now.rssBytes >= 0 && start.rssBytes >= 0)
+        d.rssBytes = now.rssBytes - start.rssBytes;
+
+    return d;
+}
@@ -0,0 +1,128 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+
+/**
+ * @brief Heap allocation counters and process memory sampling.
+ *
+ * The counters are only fed in executables that link alloc_hooks.cpp (GDQT and gdqt_bench with
+ * the GDQT_ALLOC_STATS CMake option), which replaces the global operator new and delete with
+ * counting versions. Elsewhere the counters stay at zero, @ref isAvailable returns false and
+ * @ref AllocScope does nothing. Resident set size sampling works in every build.
+ */
+namespace AllocStats
+{
+    /// Number of calls to operator new since startup.
+    extern std::atomic<quint64> allocations;
+    /// Number of calls to operator delete with a non-null pointer since startup.
+    extern std::atomic<quint64> deallocations;
+    /// Total number of bytes handed out by operator new since startup.
+    extern std::atomic<quint64> bytesAllocated;
+    /// Bytes currently allocated through operator new.
+    extern std::atomic<qint64> liveBytes;
+    /// Highest value of @ref liveBytes since startup or since the innermost open AllocScope began.
+    extern std::atomic<qint64> peakLiveBytes;
+    /// Set during static initialization by alloc_hooks.cpp when it is linked into the executable.
+    extern std::atomic<bool> hooksInstalled;
+
+    /**
+     * @brief Point-in-time copy of the allocation counters and process memory.
+     */
+    struct Snapshot
+    {
+        quint64 allocations = 0;
+        quint64 deallocations = 0;
+        quint64 bytesAllocated = 0;
+        qint64 liveBytes = 0;
+        /// Resident set size of the process in bytes, or -1 if unknown.
+        qint64 rssBytes = -1;
+    };
+
+    /**
+     * @brief Difference between two snapshots, describing one operation.
+     */
+    struct Delta
+    {
+        /// Number of allocations made during the operation.
+        quint64 allocations = 0;
+        /// Number of deallocations made during the operation.
+        quint64 deallocations = 0;
+        /// Bytes allocated during the operation, whether freed or not.
+        quint64 bytesAllocated = 0;
+        /// Change of the live heap bytes; positive if the operation kept memory.
+        qint64 liveBytes = 0;
+        /// Highest live heap size during the operation, relative to its start.
+        qint64 peakLiveBytes = 0;
+        /// Change of the resident set size in bytes, or 0 if unknown.
+        qint64 rssBytes = 0;
+    };
+
+    /**
+     * @brief Checks whether the counting operator new/delete hooks are linked into this executable.
+     */
+    bool isAvailable();
+
+    /**
+     * @brief Reads the current counters and resident set size.
+     */
+    Snapshot snapshot();
+
+    /**
+     * @brief Returns the resident set size of the process in bytes, or -1 if unknown.
+     */
+    qint64 currentRss();
+
+    /**
+     * @brief Returns the peak resident set size of the process in bytes, or -1 if unknown.
+     */
+    qint64 peakRss();
+
+    /**
+     * @brief Formats a delta as a single human-readable line.
+     */
+    QString describe(const Delta& delta);
+}
+
+/**
+ * @brief Measures the allocations made by the enclosing scope, a named operation.
+ *
+ * Scopes may be nested; each reports its own peak. When @p log is true the result is written
+ * to the debug log when the scope ends. Does nothing if the hooks are not compiled in.
+ */
+class AllocScope
+{
+public:
+    /**
+     * @brief Starts measuring an operation.
+     *
+     * @param name Operation name; must point to a string literal or other static storage.
+     * @param log Whether to log the result when the scope ends.
+     */
+    explicit AllocScope(const char* name, bool log = true);
+
+    /**
+     * @brief Stops measuring and logs the result if requested.
+     */
+    ~AllocScope();
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+    /**
+     * @brief Returns what the operation has allocated so far.
+     */
+    AllocStats::Delta delta() const;
+
+private:
+    const char* name;              ///< Operation name.
+    bool active;                   ///< Whether the hooks are available.
+    bool log;                      ///< Whether to log the result on destruction.
+    AllocStats::Snapshot start;    ///< Counters when the scope began.
+    qint64 outerPeak = 0;          ///< Peak of the enclosing scope, restored on destruction.
+};
+
+#endif // ALLOC_STATS_H
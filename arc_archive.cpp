@@ -0,0 +1,160 @@
+#include "arc_archive.h"
+#include "lz4_block.h"
+#include "trace.h"
+
+#include <QException>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace
+{
+    // Sizes of the fixed-size records
+    constexpr qint64 headerSize = 28;
+    constexpr qint64 partRecordSize = 12;
+    constexpr qint64 fileRecordSize = 44;
+}
+
+void ArcArchive::open(const QString& filename)
+{
+    TraceZone zone("ArcArchive::open");
+
+    // Forget any previously opened archive
+    file.close();
+    buffer.clear();
+    parts.clear();
+    fileEntries.clear();
+    data = nullptr;
+    size = 0;
+
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        throw QException(); // The archive can't be read
+
+    // Map the archive, or read it into memory if it can't be mapped
+    size = file.size();
+    const uchar* mapped = size > 0 ? file.map(0, size) : nullptr;
+    if (mapped) {
+        data = reinterpret_cast<const char*>(mapped);
+    } else {
+        buffer = file.readAll();
+        data = buffer.constData();
+        size = buffer.size();
+    }
+    zone.setBytes(size);
+
+    checkRange(0, headerSize);
+    if (readUInt(0) != magic || readUInt(4) != version)
+        throw QException(); // Not a version 3 archive
+
+    const quint32 fileCount = readUInt(8);
+    const quint32 partCount = readUInt(12);
+    const quint32 partTableSize = readUInt(16);
+    const quint32 stringTableSize = readUInt(20);
+    const qint64 partTable = readUInt(24);
+
+    // The part table, string table and file table follow each other after the data
+    const qint64 stringTable = partTable + partTableSize;
+    const qint64 fileTable = stringTable + stringTableSize;
+    if (qint64(partCount) * partRecordSize > partTableSize)
+        throw QException(); // Part table larger than its declared size
+    checkRange(partTable, fileTable - partTable + qint64(fileCount) * fileRecordSize);
+
+    parts.reserve(partCount);
+    for (quint32 i = 0; i < partCount; i++) {
+        const qint64 record = partTable + i * partRecordSize;
+        const Part part = {readUInt(record), readUInt(record + 4), readUInt(record + 8)};
+        if (part.compressedSize > maxEntrySize || part.decompressedSize > maxEntrySize)
+            throw QException(); // Part too large to extract
+        parts.append(part);
+    }
+
+    fileEntries.reserve(fileCount);
+    for (quint32 i = 0; i < fileCount; i++) {
+        const qint64 record = fileTable + i * fileRecordSize;
+
+        ArcEntry entry;
+        entry.type = readUInt(record);
+        entry.offset = readUInt(record + 4);
+        entry.compressedSize = readUInt(record + 8);
+        entry.decompressedSize = readUInt(record + 12);
+        if (entry.compressedSize > maxEntrySize || entry.decompressedSize > maxEntrySize)
+            throw QException(); // File too large to extract
+        // record + 16 holds a checksum that is not verified
+        entry.fileTime = readUInt(record + 20) | (quint64(readUInt(record + 24)) << 32);
+        entry.partCount = readUInt(record + 28);
+        entry.firstPart = readUInt(record + 32);
+
+        const quint32 nameLength = readUInt(record + 36);
+        const quint32 nameOffset = readUInt(record + 40);
+        if (qint64(nameOffset) + nameLength > stringTableSize)
+            throw QException(); // Name outside the string table
+        entry.name = QString::fromUtf8(data + stringTable + nameOffset, int(nameLength));
+
+        if (entry.type == 3 && qint64(entry.firstPart) + entry.partCount > parts.size())
+            throw QException(); // Parts outside the part table
+
+        fileEntries.append(entry);
+    }
+
+    zone.setItems(fileEntries.size());
+}
+
+QByteArray ArcArchive::extract(const ArcEntry& entry) const
+{
+    TraceZone zone("ArcArchive::extract");
+    zone.setBytes(entry.decompressedSize);
+
+    // Sizes and parts are checked when the archive is opened, but the entry may not come from entries()
+    if (entry.compressedSize > maxEntrySize || entry.decompressedSize > maxEntrySize)
+        throw QException(); // File too large to extract
+
+    QByteArray contents(int(entry.decompressedSize), Qt::Uninitialized);
+    char* out = contents.data();
+
+    // Copies a stored part or decompresses an LZ4 part into the output
+    auto unpack = [this, &out](qint64 offset, quint32 compressedSize, quint32 decompressedSize) {
+        checkRange(offset, compressedSize);
+        if (compressedSize == decompressedSize) {
+            memcpy(out, data + offset, decompressedSize);
+        } else if (!Lz4::decompress(data + offset, int(compressedSize), out, int(decompressedSize))) {
+            throw QException(); // Corrupt compressed data
+        }
+    };
+
+    if (entry.type != 3) {
+        unpack(entry.offset, entry.compressedSize, entry.decompressedSize);
+        return contents;
+    }
+
+    if (qint64(entry.firstPart) + entry.partCount > parts.size())
+        throw QException(); // Parts outside the part table
+
+    quint32 written = 0;
+    for (quint32 i = 0; i < entry.partCount; i++) {
+        const Part& part = parts[int(entry.firstPart + i)];
+        if (part.decompressedSize > entry.decompressedSize - written)
+            throw QException(); // Parts larger than the file
+
+        out = contents.data() + written;
+        unpack(part.offset, part.compressedSize, part.decompressedSize);
+        written += part.decompressedSize;
+    }
+
+    if (written != entry.decompressedSize)
+        throw QException(); // Parts smaller than the file
+
+    return contents;
+}
+
+quint32 ArcArchive::readUInt(qint64 offset) const
+{
+    checkRange(offset, 4);
+    return qFromLittleEndian<quint32>(data + offset);
+}
+
+void ArcArchive::checkRange(qint64 offset, qint64 length) const
+{
+    if (offset < 0 || length < 0 || offset > size || length > size - offset)
+        throw QException(); // Reference outside the archive
+}
@@ -0,0 +1,100 @@
+#ifndef ARC_ARCHIVE_H
+#define ARC_ARCHIVE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief One file stored in a Grim Dawn .arc archive.
+ */
+struct ArcEntry
+{
+    /// Path of the file inside the archive, e.g. "quests/act1/q000_devilscrossing.qst".
+    QString name;
+    /// Storage type: 1 for a file stored as is, 3 for a file split into (compressed) parts.
+    quint32 type = 0;
+    /// Offset of the data of a type 1 entry.
+    quint32 offset = 0;
+    quint32 compressedSize = 0;
+    quint32 decompressedSize = 0;
+    /// Modification time as a Windows FILETIME.
+    quint64 fileTime = 0;
+    quint32 partCount = 0;
+    quint32 firstPart = 0;
+};
+
+/**
+ * @brief Reader for Grim Dawn .arc archives (version 3), such as resources/Quests.arc.
+ *
+ * The archive starts with a 28-byte header pointing to its tables, which are stored after the
+ * data: the part table (offset, compressed and decompressed size of each part), the string
+ * table with the file names, and the file table (44 bytes per file). The data of a file is
+ * split into parts of at most 256 KiB that are LZ4 compressed unless compression did not help.
+ *
+ * The archive is memory-mapped and never modified, so entries can be extracted from several
+ * threads at once without temporary files.
+ */
+class ArcArchive
+{
+public:
+    /// "ARC\0" as a little-endian integer.
+    static constexpr quint32 magic = 0x00435241;
+    /// Supported archive version.
+    static constexpr quint32 version = 3;
+    /// Largest file or part size accepted, as extracted files are held in one QByteArray.
+    static constexpr quint32 maxEntrySize = 0x7FFFFFFF;
+
+    ArcArchive() = default;
+    ArcArchive(const ArcArchive&) = delete;
+    ArcArchive& operator=(const ArcArchive&) = delete;
+
+    /**
+     * @brief Opens an archive and reads its tables.
+     *
+     * Throws QException if the file cannot be read, is not a version 3 archive, any table
+     * points outside the file, or a file or part is larger than @ref maxEntrySize.
+     *
+     * @param filename Path of the .arc file.
+     */
+    void open(const QString& filename);
+
+    /// Returns the files of the archive, in file table order.
+    const QVector<ArcEntry>& entries() const { return fileEntries; }
+
+    /**
+     * @brief Returns the decompressed contents of one file.
+     *
+     * Thread-safe. Throws QException if the entry's data is corrupt or larger than @ref maxEntrySize.
+     *
+     * @param entry An entry of this archive.
+     * @return The file contents.
+     */
+    QByteArray extract(const ArcEntry& entry) const;
+
+private:
+    /**
+     * @brief Location of one data part of a type 3 entry.
+     */
+    struct Part
+    {
+        quint32 offset;
+        quint32 compressedSize;
+        quint32 decompressedSize;
+    };
+
+    /// Returns the little-endian integer at @p offset; throws QException if out of bounds.
+    quint32 readUInt(qint64 offset) const;
+    /// Throws QException unless the range lies inside the archive.
+    void checkRange(qint64 offset, qint64 length) const;
+
+    QFile file;                    ///< The open archive file.
+    const char* data = nullptr;    ///< Archive contents (mapped, or pointing into buffer).
+    qint64 size = 0;               ///< Size of the archive in bytes.
+    QByteArray buffer;             ///< Archive contents if the file could not be mapped.
+    QVector<Part> parts;           ///< Part table.
+    QVector<ArcEntry> fileEntries; ///< File table.
+};
+
+#endif // ARC_ARCHIVE_H
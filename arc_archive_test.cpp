@@ -0,0 +1,193 @@
+#include "arc_archive.h"
+#include "arc_writer.h"
+
+#include <QException>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QtEndian>
+
+#include <functional>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool ok, const QString& what)
+    {
+        if (ok)
+            return;
+
+        QTextStream(stderr) << "FAIL: " << what << Qt::endl;
+        failures++;
+    }
+
+    quint32 readUInt(const QByteArray& bytes, qint64 offset)
+    {
+        return qFromLittleEndian<quint32>(bytes.constData() + offset);
+    }
+
+    void setUInt(QByteArray& bytes, qint64 offset, quint32 value)
+    {
+        qToLittleEndian<quint32>(value, bytes.data() + offset);
+    }
+
+    // Offset of the file table, which follows the part and string tables
+    qint64 fileTableOffset(const QByteArray& bytes)
+    {
+        return qint64(readUInt(bytes, 24)) + readUInt(bytes, 16) + readUInt(bytes, 20);
+    }
+
+    bool writeFile(const QString& path, const QByteArray& bytes)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(bytes) == bytes.size();
+    }
+
+    // Opens the archive and extracts every entry; true if that threw QException
+    bool rejected(const QString& path, const QByteArray& bytes)
+    {
+        if (!writeFile(path, bytes))
+            return false;
+
+        try {
+            ArcArchive archive;
+            archive.open(path);
+            for (const ArcEntry& entry : archive.entries())
+                archive.extract(entry);
+        } catch (const QException&) {
+            return true;
+        }
+        return false;
+    }
+}
+
+int main()
+{
+    QTextStream out(stdout);
+    QRandomGenerator rng(20241017);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        QTextStream(stderr) << "Could not create a temporary directory" << Qt::endl;
+        return 1;
+    }
+    const QString path = dir.filePath("test.arc");
+
+    // Small parts, so files are split several times
+    const quint32 partSize = 4096;
+
+    QByteArray text;
+    while (text.size() < 3 * int(partSize) + 123)
+        text.append("Gather the fragments of the Eldritch Gate and return them to the Black Legion. ");
+
+    QByteArray noise(2 * int(partSize) + 7, Qt::Uninitialized);
+    for (char& c : noise)
+        c = char(rng.bounded(256));
+
+    // Compressible and incompressible parts within one file
+    QByteArray mixed = text.left(int(partSize)) + noise.left(int(partSize)) + text.left(int(partSize) / 2);
+
+    struct Input
+    {
+        QString name;
+        QByteArray contents;
+        quint64 fileTime;
+    };
+    const QVector<Input> inputs = {
+        {"quests/empty.qst", QByteArray(), 0},
+        {"quests/byte.qst", QByteArray("x"), 1},
+        {"quests/act1/text.qst", text, 0x01D9A1B2C3D4E5F6ULL},
+        {"quests/act1/noise.qst", noise, 2},
+        {"quests/act2/mixed.qst", mixed, 3},
+        {"quests/act2/one_part.qst", text.left(int(partSize)), 4},
+    };
+
+    ArcWriter writer(partSize);
+    for (const Input& input : inputs)
+        writer.addFile(input.name, input.contents, input.fileTime);
+    const QByteArray bytes = writer.encode();
+
+    // Writing and reading back gives the same files, in the same order
+    check(writer.write(path), "archive could not be written");
+    try {
+        ArcArchive archive;
+        archive.open(path);
+        const QVector<ArcEntry>& entries = archive.entries();
+        check(entries.size() == inputs.size(), "wrong number of entries");
+
+        for (int i = 0; i < qMin(entries.size(), inputs.size()); i++) {
+            const ArcEntry& entry = entries[i];
+            const Input& input = inputs[i];
+            const quint32 expectedParts = (quint32(input.contents.size()) + partSize - 1) / partSize;
+
+            check(entry.name == input.name, input.name + ": name differs");
+            check(entry.fileTime == input.fileTime, input.name + ": file time differs");
+            check(entry.decompressedSize == quint32(input.contents.size()), input.name + ": size differs");
+            check(entry.partCount == expectedParts, input.name + ": part count differs");
+            check(archive.extract(entry) == input.contents, input.name + ": contents differ");
+        }
+
+        // Text is stored compressed, noise as is
+        check(entries.size() > 3 && entries[2].compressedSize < entries[2].decompressedSize, "text was not compressed");
+        check(entries.size() > 3 && entries[3].compressedSize == entries[3].decompressedSize, "noise was not stored as is");
+
+        // Entries that did not come from entries() are checked against the part table as well
+        for (quint32 firstPart : {readUInt(bytes, 12) - 1, 0xFFFFFFFFu}) {
+            if (entries.size() < 3)
+                break;
+
+            ArcEntry forged = entries[2];
+            forged.firstPart = firstPart;
+            bool rejected = false;
+            try {
+                archive.extract(forged);
+            } catch (const QException&) {
+                rejected = true;
+            }
+            check(rejected, QString("entry with first part %1 was extracted").arg(firstPart));
+        }
+    } catch (const QException&) {
+        check(false, "written archive could not be read");
+    }
+
+    // Corrupt archives are rejected when opened or extracted, never read out of bounds
+    const qint64 fileTable = fileTableOffset(bytes);
+    const qint64 textRecord = fileTable + 2 * 44;
+    const qint64 textPart = readUInt(bytes, 24) + qint64(readUInt(bytes, textRecord + 32)) * 12;
+
+    const QVector<QPair<QString, std::function<void(QByteArray&)>>> corruptions = {
+        {"bad magic", [](QByteArray& b) { b[0] = 'X'; }},
+        {"unsupported version", [](QByteArray& b) { setUInt(b, 4, 2); }},
+        {"truncated tables", [](QByteArray& b) { b.chop(1); }},
+        {"truncated header", [](QByteArray& b) { b.truncate(27); }},
+        {"too many files", [](QByteArray& b) { setUInt(b, 8, 0x10000000); }},
+        {"too many parts", [](QByteArray& b) { setUInt(b, 12, readUInt(b, 12) + 1); }},
+        {"part table outside the file", [](QByteArray& b) { setUInt(b, 24, 0xFFFFFFF0); }},
+        {"name outside the string table", [=](QByteArray& b) { setUInt(b, textRecord + 36, readUInt(b, 20) + 1); }},
+        {"first part outside the part table", [=](QByteArray& b) { setUInt(b, textRecord + 32, readUInt(b, 12)); }},
+        {"file larger than an extractable size", [=](QByteArray& b) { setUInt(b, textRecord + 12, 0x80000000); }},
+        {"part larger than an extractable size", [=](QByteArray& b) { setUInt(b, textPart + 8, 0xFFFFFFFF); }},
+        {"part data outside the file", [=](QByteArray& b) { setUInt(b, textPart, 0xFFFFFF00); }},
+        {"parts larger than the file", [=](QByteArray& b) { setUInt(b, textRecord + 12, readUInt(b, textRecord + 12) - 1); }},
+        {"parts smaller than the file", [=](QByteArray& b) { setUInt(b, textRecord + 12, readUInt(b, textRecord + 12) + 1); }},
+        {"corrupt LZ4 block", [=](QByteArray& b) {
+             // A run of 0xFF is a literal length far past the end of the block
+             const quint32 offset = readUInt(b, textPart);
+             const quint32 compressedSize = readUInt(b, textPart + 4);
+             for (quint32 i = 0; i < compressedSize; i++)
+                 b[int(offset + i)] = char(0xFF);
+         }},
+        {"truncated LZ4 block", [=](QByteArray& b) { setUInt(b, textPart + 4, readUInt(b, textPart + 4) - 1); }},
+    };
+
+    check(readUInt(bytes, textPart + 4) < readUInt(bytes, textPart + 8), "first text part is not compressed");
+    for (const auto& corruption : corruptions) {
+        QByteArray corrupt = bytes;
+        corruption.second(corrupt);
+        check(rejected(path, corrupt), corruption.first + ": archive was accepted");
+    }
+
+    out << inputs.size() << " files, " << corruptions.size() << " corruptions, " << failures << " failures" << Qt::endl;
+    return failures == 0 ? 0 : 1;
+}
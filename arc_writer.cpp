@@ -0,0 +1,109 @@
+#include "arc_writer.h"
+#include "arc_archive.h"
+#include "lz4_block.h"
+
+#include <QFile>
+#include <QtEndian>
+
+namespace
+{
+    void appendUInt(QByteArray& out, quint32 value)
+    {
+        char bytes[4];
+        qToLittleEndian<quint32>(value, bytes);
+        out.append(bytes, 4);
+    }
+
+    void setUInt(QByteArray& out, qsizetype offset, quint32 value)
+    {
+        qToLittleEndian<quint32>(value, out.data() + offset);
+    }
+}
+
+ArcWriter::ArcWriter(quint32 partSize) : partSize(qMax<quint32>(partSize, 1)) {}
+
+void ArcWriter::addFile(const QString& name, const QByteArray& contents, quint64 fileTime)
+{
+    files.append({name, contents, fileTime});
+}
+
+QByteArray ArcWriter::encode() const
+{
+    struct Part
+    {
+        quint32 offset;
+        quint32 compressedSize;
+        quint32 decompressedSize;
+    };
+
+    // Header, filled in at the end
+    QByteArray out(28, '\0');
+    QVector<Part> parts;
+    QByteArray strings;
+    QByteArray fileTable;
+
+    for (const File& file : files) {
+        const quint32 firstPart = quint32(parts.size());
+        const quint32 dataOffset = quint32(out.size());
+        quint32 compressedTotal = 0;
+
+        // Data parts, compressed unless that doesn't make them smaller
+        for (qsizetype pos = 0; pos < file.contents.size(); pos += partSize) {
+            const QByteArray chunk = file.contents.mid(pos, partSize);
+            const QByteArray compressed = Lz4::compress(chunk);
+            const QByteArray& stored = compressed.size() < chunk.size() ? compressed : chunk;
+
+            parts.append({quint32(out.size()), quint32(stored.size()), quint32(chunk.size())});
+            out.append(stored);
+            compressedTotal += quint32(stored.size());
+        }
+
+        // Names are stored null-terminated; the file table holds their length without the terminator
+        const QByteArray name = file.name.toUtf8();
+        const quint32 nameOffset = quint32(strings.size());
+        strings.append(name);
+        strings.append('\0');
+
+        appendUInt(fileTable, 3);
+        appendUInt(fileTable, dataOffset);
+        appendUInt(fileTable, compressedTotal);
+        appendUInt(fileTable, quint32(file.contents.size()));
+        appendUInt(fileTable, 0);
+        appendUInt(fileTable, quint32(file.fileTime));
+        appendUInt(fileTable, quint32(file.fileTime >> 32));
+        appendUInt(fileTable, quint32(parts.size()) - firstPart);
+        appendUInt(fileTable, firstPart);
+        appendUInt(fileTable, quint32(name.size()));
+        appendUInt(fileTable, nameOffset);
+    }
+
+    // Tables after the data: parts, names, files
+    const quint32 partTable = quint32(out.size());
+    for (const Part& part : parts) {
+        appendUInt(out, part.offset);
+        appendUInt(out, part.compressedSize);
+        appendUInt(out, part.decompressedSize);
+    }
+    out.append(strings);
+    out.append(fileTable);
+
+    setUInt(out, 0, ArcArchive::magic);
+    setUInt(out, 4, ArcArchive::version);
+    setUInt(out, 8, quint32(files.size()));
+    setUInt(out, 12, quint32(parts.size()));
+    setUInt(out, 16, quint32(parts.size() * 12));
+    setUInt(out, 20, quint32(strings.size()));
+    setUInt(out, 24, partTable);
+
+    return out;
+}
+
+bool ArcWriter::write(const QString& filename) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    const QByteArray bytes = encode();
+    return file.write(bytes) == bytes.size();
+}
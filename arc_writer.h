@@ -0,0 +1,64 @@
+#ifndef ARC_WRITER_H
+#define ARC_WRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Class for writing .arc archives in the format read by ArcArchive.
+ *
+ * Splits every file into parts of @ref partSize bytes and LZ4 compresses each part, storing it
+ * as is when compression does not make it smaller, as the game's archives do. Used to produce
+ * synthetic archives for benchmarks and checks, so no game install is needed.
+ */
+class ArcWriter
+{
+public:
+    /**
+     * @brief Constructs a writer that splits files into parts of @p partSize bytes.
+     *
+     * @param partSize Maximum decompressed size of one part.
+     */
+    explicit ArcWriter(quint32 partSize = 256 * 1024);
+
+    /**
+     * @brief Adds a file to the archive.
+     *
+     * @param name Path of the file inside the archive.
+     * @param contents File contents.
+     * @param fileTime Modification time as a Windows FILETIME.
+     */
+    void addFile(const QString& name, const QByteArray& contents, quint64 fileTime = 0);
+
+    /**
+     * @brief Encodes all added files into an archive.
+     *
+     * @return The raw archive contents, readable by ArcArchive.
+     */
+    QByteArray encode() const;
+
+    /**
+     * @brief Encodes all added files and writes the archive to disk.
+     *
+     * @param filename The path of the file to create or overwrite.
+     * @return True if the file was written successfully; otherwise false.
+     */
+    bool write(const QString& filename) const;
+
+private:
+    /**
+     * @brief A file waiting to be encoded.
+     */
+    struct File
+    {
+        QString name;
+        QByteArray contents;
+        quint64 fileTime;
+    };
+
+    QVector<File> files;   ///< Files in the order they were added.
+    quint32 partSize;      ///< Maximum decompressed size of one part.
+};
+
+#endif // ARC_WRITER_H
@@ -0,0 +1,654 @@
+#include "alloc_stats.h"
+#include "gdd_parser.h"
+#include "gdd_generator.h"
+#include "parse_context.h"
+#include "jsonparser.h"
+#include "quest_database.h"
+#include "qst_parser.h"
+#include "arc_writer.h"
+#include "questtrackerwindow.h"
+#include "utils.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QtEndian>
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+    /**
+     * @brief One measured case and its result.
+     */
+    struct BenchResult
+    {
+        QString name;
+        qint64 iterations = 0;
+        qint64 medianNs = 0;
+        qint64 minNs = 0;
+        qint64 meanNs = 0;
+        qint64 bytes = 0;   // Bytes processed per iteration, 0 if not meaningful
+        qint64 items = 0;   // Items processed per iteration, 0 if not meaningful
+        qint64 allocations = -1;     // Heap allocations per iteration, -1 without GDQT_ALLOC_STATS
+        qint64 allocatedBytes = -1;  // Heap bytes allocated per iteration
+        qint64 peakBytes = -1;       // Highest live heap growth during one iteration
+    };
+
+    /**
+     * @brief Input sizes every case is run at.
+     */
+    struct Scale
+    {
+        const char* name;
+        quint32 quests;
+    };
+
+    // "real" matches the size of the shipped quest database; "100x" is a stress size
+    const Scale scales[] = {{"small", 20}, {"real", 400}, {"100x", 40000}};
+
+    void silentMessageHandler(QtMsgType, const QMessageLogContext&, const QString&) {}
+
+    class BenchRunner
+    {
+    public:
+        BenchRunner(const QRegularExpression& filter, qint64 minTimeMs)
+            : m_filter(filter), m_minTimeNs(minTimeMs * 1000000) {}
+
+        // Runs fn repeatedly until the minimum time has passed and records the per-iteration statistics
+        void run(const QString& name, qint64 bytes, qint64 items, const std::function<void()>& fn)
+        {
+            if (!m_filter.match(name).hasMatch())
+                return;
+
+            // One untimed warm-up iteration
+            fn();
+
+            QVector<qint64> samples;
+            qint64 total = 0;
+            QElapsedTimer timer;
+
+            while (samples.size() < 5 || (total < m_minTimeNs && samples.size() < 100000)) {
+                timer.start();
+                fn();
+                qint64 ns = timer.nsecsElapsed();
+
+                samples.append(ns);
+                total += ns;
+            }
+
+            std::sort(samples.begin(), samples.end());
+
+            BenchResult result;
+            result.name = name;
+            result.iterations = samples.size();
+            result.medianNs = samples[samples.size() / 2];
+            result.minNs = samples.first();
+            result.meanNs = total / samples.size();
+            result.bytes = bytes;
+            result.items = items;
+
+            // One more iteration, outside the timing, to count its allocations
+            if (AllocStats::isAvailable()) {
+                AllocScope scope("bench", false);
+                fn();
+
+                AllocStats::Delta delta = scope.delta();
+                result.allocations = qint64(delta.allocations);
+                result.allocatedBytes = qint64(delta.bytesAllocated);
+                result.peakBytes = delta.peakLiveBytes;
+            }
+
+            m_results.append(result);
+
+            QTextStream out(stdout);
+            out << QString("%1 %2 us/iter (min %3 us, %4 iterations)")
+                       .arg(name, -40)
+                       .arg(result.medianNs / 1000.0, 12, 'f', 2)
+                       .arg(result.minNs / 1000.0, 0, 'f', 2)
+                       .arg(result.iterations);
+            if (bytes > 0)
+                out << QString(", %1 MB/s").arg(bytes * 1000.0 / result.medianNs, 0, 'f', 1);
+            if (result.allocations >= 0)
+                out << QString(", %1 allocs, %2 KiB, peak %3 KiB").arg(result.allocations).arg(result.allocatedBytes / 1024.0, 0, 'f', 1).arg(result.peakBytes / 1024.0, 0, 'f', 1);
+            out << Qt::endl;
+        }
+
+        const QVector<BenchResult>& results() const { return m_results; }
+
+    private:
+        QRegularExpression m_filter;
+        qint64 m_minTimeNs;
+        QVector<BenchResult> m_results;
+    };
+
+    // Builds a quests.json-style database with the given number of entries
+    QByteArray makeQuestJson(quint32 entries)
+    {
+        QJsonObject root;
+        QRandomGenerator rng(42);
+
+        for (quint32 i = 0; i < entries; i++) {
+            QJsonObject quest;
+            quest["Chapter"] = QString("Chapter %1").arg(i % 40);
+            quest["QuestName"] = i % 10 == 0 ? QString("Bounty: Synthetic %1").arg(i) : QString("Synthetic Quest %1").arg(i);
+            root[QString("0x%1").arg(rng.generate(), 8, 16, QChar('0'))] = quest;
+        }
+
+        return QJsonDocument(root).toJson(QJsonDocument::Indented);
+    }
+
+    // Builds a QST-like file: a header with the quest hash at offset 12, script filler and an enUS block
+    QByteArray makeQstFile(quint32 hash, quint32 index)
+    {
+        QByteArray data(16, '\0');
+        qToLittleEndian<quint32>(hash, data.data() + 12);
+
+        data.append(QByteArray(2048, '\x01'));
+
+        auto appendString = [&data](const QByteArray& str) {
+            char len[4];
+            qToLittleEndian<quint32>(quint32(str.size() + 1), len);
+            data.append(len, 4);
+            data.append(str);
+            data.append('\0');
+        };
+
+        data.append("enUS");
+        appendString(QString("Chapter %1").arg(index % 40).toUtf8());
+        appendString(QString("Synthetic Quest %1").arg(index).toUtf8());
+
+        return data;
+    }
+
+    /**
+     * @brief The quests.gdd decoder as it was before QuestsFile read through an in-memory cursor.
+     *
+     * Every primitive is a QDataStream::readRawData call on the open QFile, strings and UIDs are
+     * read byte by byte, and block ends are checked with QFile::pos(). Kept only as the
+     * reference point of gdd/read-datastream.
+     */
+    class DataStreamQuestsReader
+    {
+    public:
+        void read(const QString& filename)
+        {
+            QFile f(filename);
+            if (!f.open(QIODevice::ReadOnly))
+                throw QException();
+
+            file = &f;
+            QDataStream s(&f);
+            s.setByteOrder(QDataStream::LittleEndian);
+            stream = &s;
+
+            readKey();
+            if (readInt() != 0x58545351 || readInt() != 0)
+                throw QException();
+            readUid(id);
+
+            // Token list
+            Block b;
+            if (readBlockStart(&b) != 10 || readInt() != 2)
+                throw QException();
+            tokens.resize(int(readInt()));
+            for (String& token : tokens) {
+                const quint32 len = readInt();
+                token.clear();
+                for (quint32 i = 0; i < len; i++)
+                    token.append(QChar(readByte()));
+            }
+            readBlockEnd(&b);
+
+            // Quest list
+            if (readBlockStart(&b) != 11 || readInt() != 4)
+                throw QException();
+            quests.resize(int(readInt()));
+            for (Quest& quest : quests) {
+                Block questBlock;
+                quest.id1 = readInt();
+                readUid(quest.id2);
+                if (readBlockStart(&questBlock))
+                    throw QException();
+
+                quest.tasks.resize(int(readInt()));
+                for (Task& task : quest.tasks) {
+                    Block taskBlock;
+                    task.id1 = readInt();
+                    readUid(task.id2);
+                    if (readBlockStart(&taskBlock) != 0)
+                        throw QException();
+
+                    task.state = readInt();
+                    task.inProgress = readByte();
+                    readByte();
+
+                    task.objectives.resize(int((taskBlock.len - 6) / 4));
+                    for (quint32& objective : task.objectives)
+                        objective = readInt();
+                    readBlockEnd(&taskBlock);
+                }
+                readBlockEnd(&questBlock);
+            }
+            readBlockEnd(&b);
+
+            if (f.pos() != f.size())
+                throw QException();
+        }
+
+        UID id;
+        Vector<String> tokens;
+        Vector<Quest> quests;
+
+    private:
+        void readKey()
+        {
+            quint32 k = rawInt() ^ 0x55555555;
+            key = k;
+            for (unsigned i = 0; i < 256; i++) {
+                k = (k >> 1) | (k << 31);
+                k *= 39916801;
+                table[i] = k;
+            }
+        }
+
+        quint32 rawInt()
+        {
+            quint32 val;
+            if (stream->readRawData(reinterpret_cast<char*>(&val), sizeof(val)) != sizeof(val))
+                throw QException();
+            return val;
+        }
+
+        quint32 nextInt() { return rawInt() ^ key; }
+
+        quint32 readInt()
+        {
+            quint32 val = rawInt();
+            quint32 ret = val ^ key;
+            const quint8* p = reinterpret_cast<const quint8*>(&val);
+            for (unsigned i = 0; i < sizeof(val); i++)
+                key ^= table[p[i]];
+            return ret;
+        }
+
+        quint8 readByte()
+        {
+            quint8 val;
+            if (stream->readRawData(reinterpret_cast<char*>(&val), sizeof(val)) != sizeof(val))
+                throw QException();
+            quint8 ret = val ^ key;
+            key ^= table[val];
+            return ret;
+        }
+
+        void readUid(UID& uid)
+        {
+            for (unsigned i = 0; i < 16; i++)
+                uid.id[i] = readByte();
+        }
+
+        quint32 readBlockStart(Block* b)
+        {
+            quint32 ret = readInt();
+            b->len = nextInt();
+            b->end = file->pos() + b->len;
+            return ret;
+        }
+
+        void readBlockEnd(Block* b)
+        {
+            if (file->pos() != b->end || nextInt() != 0)
+                throw QException();
+        }
+
+        QFile* file = nullptr;
+        QDataStream* stream = nullptr;
+        quint32 key = 0;
+        quint32 table[256];
+    };
+
+    bool writeFile(const QString& path, const QByteArray& bytes)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(bytes) == bytes.size();
+    }
+
+    QJsonObject resultsToJson(const QVector<BenchResult>& results)
+    {
+        QJsonArray cases;
+        for (const BenchResult& r : results) {
+            QJsonObject c;
+            c["name"] = r.name;
+            c["iterations"] = r.iterations;
+            c["median_ns"] = r.medianNs;
+            c["min_ns"] = r.minNs;
+            c["mean_ns"] = r.meanNs;
+            c["bytes"] = r.bytes;
+            c["items"] = r.items;
+            if (r.allocations >= 0) {
+                c["allocations"] = r.allocations;
+                c["allocated_bytes"] = r.allocatedBytes;
+                c["peak_bytes"] = r.peakBytes;
+            }
+            cases.append(c);
+        }
+
+        QJsonObject root;
+        root["format"] = 1;
+        root["qt"] = QString(qVersion());
+        root["cases"] = cases;
+        return root;
+    }
+
+    // Prints current vs. baseline medians and allocation counts; returns the number of cases that
+    // got slower or allocate more by more than the threshold, or -1 if the baseline can't be read
+    int compareWithBaseline(const QVector<BenchResult>& results, const QString& baselinePath, double threshold)
+    {
+        QTextStream out(stdout);
+
+        QFile file(baselinePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            out << "Could not open baseline " << baselinePath << Qt::endl;
+            return -1;
+        }
+
+        QJsonParseError parseError;
+        const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+        if (parseError.error != QJsonParseError::NoError || !document.object().value("cases").isArray()) {
+            out << "Baseline " << baselinePath << " is not a gdqt_bench result file" << Qt::endl;
+            return -1;
+        }
+
+        QMap<QString, qint64> baseline;
+        QMap<QString, qint64> baselineAllocations;
+        const QJsonArray cases = document.object().value("cases").toArray();
+        for (const QJsonValue& value : cases) {
+            QJsonObject c = value.toObject();
+            baseline.insert(c.value("name").toString(), qint64(c.value("median_ns").toDouble()));
+            if (c.contains("allocations"))
+                baselineAllocations.insert(c.value("name").toString(), qint64(c.value("allocations").toDouble()));
+        }
+
+        int regressions = 0;
+        out << Qt::endl << QString("%1 %2 %3 %4").arg("case", -40).arg("baseline us", 14).arg("current us", 14).arg("ratio", 8) << Qt::endl;
+
+        for (const BenchResult& r : results) {
+            if (!baseline.contains(r.name) || baseline.value(r.name) <= 0) {
+                out << QString("%1 %2").arg(r.name, -40).arg("(new)", 14) << Qt::endl;
+                continue;
+            }
+
+            double ratio = double(r.medianNs) / baseline.value(r.name);
+            QString verdict;
+            if (ratio > 1.0 + threshold) {
+                verdict = "  SLOWER";
+                regressions++;
+            } else if (ratio < 1.0 - threshold) {
+                verdict = "  faster";
+            }
+
+            // Allocation counts are deterministic, so any growth beyond the threshold is reported
+            if (r.allocations >= 0 && baselineAllocations.contains(r.name)) {
+                qint64 before = baselineAllocations.value(r.name);
+                verdict += QString("  allocs %1 -> %2").arg(before).arg(r.allocations);
+                if (r.allocations > before * (1.0 + threshold)) {
+                    verdict += " MORE";
+                    if (ratio <= 1.0 + threshold)
+                        regressions++;
+                }
+            }
+
+            out << QString("%1 %2 %3 %4%5")
+                       .arg(r.name, -40)
+                       .arg(baseline.value(r.name) / 1000.0, 14, 'f', 2)
+                       .arg(r.medianNs / 1000.0, 14, 'f', 2)
+                       .arg(ratio, 8, 'f', 3)
+                       .arg(verdict)
+                << Qt::endl;
+        }
+
+        return regressions;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // The window benchmarks need a platform plugin, but never a visible screen
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gdqt_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Microbenchmarks of the GDQT parse and model hot paths.");
+    parser.addHelpOption();
+
+    QCommandLineOption filterOption("filter", "Only run cases whose name matches this regular expression.", "regex", ".");
+    QCommandLineOption minTimeOption("min-time", "Minimum measuring time per case in milliseconds.", "ms", "300");
+    QCommandLineOption outOption("out", "Write machine-readable results to this JSON file.", "path");
+    QCommandLineOption baselineOption("baseline", "Compare against results saved earlier with --out.", "path");
+    QCommandLineOption thresholdOption("threshold", "Relative slowdown reported as a regression.", "fraction", "0.05");
+    QCommandLineOption verboseOption("verbose", "Keep the parsers' log output.");
+    parser.addOptions({filterOption, minTimeOption, outOption, baselineOption, thresholdOption, verboseOption});
+    parser.process(app);
+
+    // Parser logging would dominate the measurements and flood the console
+    if (!parser.isSet(verboseOption))
+        qInstallMessageHandler(silentMessageHandler);
+
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        QTextStream(stderr) << "Could not create a temporary directory" << Qt::endl;
+        return 1;
+    }
+
+    // Everything that writes relative to the current directory (settings, generated quests.json) stays in the sandbox
+    QDir::setCurrent(workDir.path());
+
+    BenchRunner bench(QRegularExpression(parser.value(filterOption)), parser.value(minTimeOption).toLongLong());
+
+    for (const Scale& scale : scales) {
+        const QString suffix = QString("/%1").arg(scale.name);
+
+        // quests.gdd decoding: in memory, from disk, streamed and flat
+        SyntheticSaveOptions options;
+        options.quests = scale.quests;
+        options.tasksPerQuest = 6;
+        options.objectivesPerTask = 8;
+        options.tokens = scale.quests / 2;
+
+        const QByteArray gdd = GddGenerator::generateBytes(options);
+        const QString gddPath = workDir.filePath(QString("quests_%1.gdd").arg(scale.name));
+        writeFile(gddPath, gdd);
+
+        const uchar* gddData = reinterpret_cast<const uchar*>(gdd.constData());
+
+        bench.run("gdd/readFromMemory" + suffix, gdd.size(), scale.quests, [&] {
+            QuestsFile file;
+            file.readFromMemory(gddData, gdd.size());
+        });
+
+        bench.run("gdd/read" + suffix, gdd.size(), scale.quests, [&] {
+            QuestsFile file;
+            file.read(gddPath);
+        });
+
+        // The same decode through QDataStream primitives, as QuestsFile::read did originally
+        bench.run("gdd/read-datastream" + suffix, gdd.size(), scale.quests, [&] {
+            DataStreamQuestsReader reader;
+            reader.read(gddPath);
+        });
+
+        bench.run("gdd/visitStatesOnly" + suffix, gdd.size(), scale.quests, [&] {
+            struct StateVisitor : QuestsVisitor {
+                bool wantsTokens() const override { return false; }
+                bool wantsObjectives() const override { return false; }
+                void onTask(quint32, const UID&, quint32 state, quint32) override { completed += state == 3; }
+                quint32 completed = 0;
+            } visitor;
+
+            QuestsFile file;
+            file.visitFromMemory(gddData, gdd.size(), visitor);
+        });
+
+        GddParseContext context;
+        bench.run("gdd/parseContextFlat" + suffix, gdd.size(), scale.quests, [&] {
+            context.parse(gddPath);
+        });
+
+        // Quest database loading
+        const QByteArray json = makeQuestJson(scale.quests);
+        const QString jsonPath = workDir.filePath(QString("quests_%1.json").arg(scale.name));
+        writeFile(jsonPath, json);
+
+        bench.run("json/read" + suffix, json.size(), scale.quests, [&] {
+            JsonParser parser;
+            parser.read(jsonPath);
+        });
+
+        // The resident database is only loaded again once its files change
+        bench.run("db/load" + suffix, json.size(), scale.quests, [&] {
+            QuestDatabase::invalidate();
+            QuestDatabase::load(jsonPath);
+        });
+
+        bench.run("db/load-resident" + suffix, 0, scale.quests, [&] {
+            QuestDatabase::load(jsonPath);
+        });
+
+        const std::shared_ptr<const QuestDatabase> database = QuestDatabase::load(jsonPath);
+        bench.run("db/find" + suffix, 0, database->count(), [&] {
+            int found = 0;
+            for (int i = 0; i < database->count(); i++)
+                found += database->find(database->hashAt(i)) >= 0;
+            Q_UNUSED(found);
+        });
+
+        // QST parsing and database generation
+        const QString qstDir = workDir.filePath(QString("qst_%1").arg(scale.name));
+        QDir().mkpath(qstDir);
+
+        QRandomGenerator rng(7);
+        qint64 qstBytes = 0;
+        const quint32 qstCount = qMin<quint32>(scale.quests, 4000);
+        for (quint32 i = 0; i < qstCount; i++) {
+            QByteArray qst = makeQstFile(rng.generate(), i);
+            qstBytes += qst.size();
+            writeFile(QString("%1/quest_%2.qst").arg(qstDir).arg(i, 5, 10, QChar('0')), qst);
+        }
+
+        const QString firstQst = QString("%1/quest_%2.qst").arg(qstDir).arg(0, 5, 10, QChar('0'));
+        bench.run("qst/parse" + suffix, qstBytes / qstCount, 1, [&] {
+            QstFile qst(firstQst);
+            qst.parse();
+        });
+
+        // Full scans remove the manifest first; the unchanged case measures an incremental rerun
+        const QString qstJsonPath = workDir.filePath(QString("qst_%1.json").arg(scale.name));
+        bench.run("qst/generateQuestJson" + suffix, qstBytes, qstCount, [&] {
+            QFile::remove(qstJsonPath + ".manifest");
+            generateQuestJson(qstDir, qstJsonPath);
+        });
+
+        bench.run("qst/generateQuestJson-unchanged" + suffix, 0, qstCount, [&] {
+            generateQuestJson(qstDir, qstJsonPath);
+        });
+
+        // The same files packed into a Quests.arc archive, read without extracting
+        ArcWriter arcWriter;
+        for (quint32 i = 0; i < qstCount; i++) {
+            const QString name = QString("quest_%1.qst").arg(i, 5, 10, QChar('0'));
+            QFile qstFile(QString("%1/%2").arg(qstDir, name));
+            qstFile.open(QIODevice::ReadOnly);
+            arcWriter.addFile("quests/" + name, qstFile.readAll());
+        }
+
+        const QString arcPath = workDir.filePath(QString("quests_%1.arc").arg(scale.name));
+        arcWriter.write(arcPath);
+
+        bench.run("qst/generateQuestJson-arc" + suffix, qstBytes, qstCount, [&] {
+            QFile::remove(qstJsonPath + ".manifest");
+            generateQuestJson(arcPath, qstJsonPath);
+        });
+
+        // Quest status model
+        JsonParser catalog;
+        catalog.read(jsonPath);
+
+        const QList<Difficulty> difficulties = Difficulty::getAllDifficulties();
+        auto fillModel = [&](QuestData& data) {
+            int i = 0;
+            for (const QuestInfo& info : catalog.questData) {
+                for (const Difficulty& difficulty : difficulties)
+                    data.setStatus(info.Chapter, info.QuestName, difficulty.name, QuestStatus::Status((i + int(difficulty.level)) % 3));
+                i++;
+            }
+        };
+
+        const qint64 statusCount = qint64(catalog.questData.size()) * difficulties.size();
+
+        bench.run("model/setStatus" + suffix, 0, statusCount, [&] {
+            QuestData data;
+            fillModel(data);
+        });
+
+        QuestData questData;
+        fillModel(questData);
+
+        bench.run("model/getStatus" + suffix, 0, statusCount, [&] {
+            int completed = 0;
+            for (const QuestInfo& info : catalog.questData) {
+                for (const Difficulty& difficulty : difficulties)
+                    completed += questData.getStatus(info.Chapter, info.QuestName, difficulty.name).status == QuestStatus::Completed;
+            }
+            Q_UNUSED(completed);
+        });
+
+        // Table model building and filtering through the real window
+        QuestTrackerWindow window;
+        if (!parser.isSet(verboseOption))
+            qInstallMessageHandler(silentMessageHandler); // The window installs its own log handler
+
+        bench.run("ui/populateTableView" + suffix, 0, catalog.questData.size(), [&] {
+            window.populateTableView(questData);
+        });
+
+        const QStringList keystrokes = {"s", "sy", "syn", "synt", "synthetic q", "quest 1", ""};
+        bench.run("ui/filterTable" + suffix, 0, keystrokes.size(), [&] {
+            for (const QString& text : keystrokes)
+                window.filterTable(text);
+        });
+    }
+
+    if (parser.isSet(outOption)) {
+        QFile out(parser.value(outOption));
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "Could not write " << parser.value(outOption) << Qt::endl;
+            return 1;
+        }
+        out.write(QJsonDocument(resultsToJson(bench.results())).toJson(QJsonDocument::Indented));
+    }
+
+    if (parser.isSet(baselineOption)) {
+        int regressions = compareWithBaseline(bench.results(), parser.value(baselineOption), parser.value(thresholdOption).toDouble());
+        if (regressions < 0)
+            return 1; // An unusable baseline is an error, not a regression
+        if (regressions > 0)
+            return 3;
+    }
+
+    return 0;
+}
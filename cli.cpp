@@ -0,0 +1,302 @@
+#include "gdd_parser.h"
+#include "perf_counters.h"
+#include "quest_database.h"
+#include "quest_status.h"
+#include "utils.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QException>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <cstdio>
+
+namespace
+{
+    bool verboseOutput = false;
+
+    // Keeps stdout clean for the dumps; diagnostics go to stderr, debug output only with --verbose
+    void messageHandler(QtMsgType type, const QMessageLogContext &, const QString &message)
+    {
+        if (type == QtDebugMsg && !verboseOutput)
+            return;
+
+        fprintf(stderr, "%s\n", qPrintable(message));
+        fflush(stderr);
+    }
+
+    // Stable machine-readable status keys, independent of the texts shown in the GUI
+    QString statusKey(QuestStatus::Status status)
+    {
+        switch (status) {
+        case QuestStatus::Completed: return "completed";
+        case QuestStatus::InProgress: return "in_progress";
+        default: return "not_completed";
+        }
+    }
+
+    QString csvField(const QString &value)
+    {
+        if (!value.contains(',') && !value.contains('"') && !value.contains('\n'))
+            return value;
+
+        QString escaped = value;
+        escaped.replace('"', "\"\"");
+        return '"' + escaped + '"';
+    }
+
+    /**
+     * @brief Writes the status of every character in the requested format.
+     */
+    class StatusWriter
+    {
+    public:
+        StatusWriter(QTextStream &out, const QString &format) : out(out), format(format)
+        {
+            if (format == "csv")
+                out << "save,character,chapter,quest,normal,elite,ultimate\n";
+        }
+
+        void addCharacter(const QString &saveDir, const QString &character, const QuestData &questData)
+        {
+            QJsonArray quests;
+
+            for (const QString &chapter : questData.chapters()) {
+                for (const QString &quest : questData.quests(chapter)) {
+                    QString normal = statusKey(questData.getStatus(chapter, quest, "Normal").status);
+                    QString elite = statusKey(questData.getStatus(chapter, quest, "Elite").status);
+                    QString ultimate = statusKey(questData.getStatus(chapter, quest, "Ultimate").status);
+
+                    if (format == "csv") {
+                        out << csvField(saveDir) << ',' << csvField(character) << ',' << csvField(chapter) << ','
+                            << csvField(quest) << ',' << normal << ',' << elite << ',' << ultimate << '\n';
+                        continue;
+                    }
+
+                    QJsonObject entry{{"chapter", chapter}, {"quest", quest},
+                                      {"normal", normal}, {"elite", elite}, {"ultimate", ultimate}};
+
+                    if (format == "ndjson") {
+                        entry.insert("save", saveDir);
+                        entry.insert("character", character);
+                        out << QJsonDocument(entry).toJson(QJsonDocument::Compact) << '\n';
+                    } else {
+                        quests.append(entry);
+                    }
+                }
+            }
+
+            if (format == "json")
+                characters.append(QJsonObject{{"save", saveDir}, {"character", character}, {"quests", quests}});
+        }
+
+        void finish()
+        {
+            if (format == "json")
+                out << QJsonDocument(characters).toJson(QJsonDocument::Indented);
+            out.flush();
+        }
+
+    private:
+        QTextStream &out;
+        QString format;
+        QJsonArray characters;
+    };
+
+    int runStatus(const QCommandLineParser &parser, QTextStream &out, QTextStream &err)
+    {
+        const QString format = parser.value("format");
+        if (format != "json" && format != "csv" && format != "ndjson") {
+            err << "Unknown format: " << format << "\n";
+            return 2;
+        }
+
+        const QStringList saveDirs = parser.values("saves");
+        if (saveDirs.isEmpty()) {
+            err << "status needs at least one --saves directory\n";
+            return 2;
+        }
+
+        std::shared_ptr<const QuestDatabase> database;
+        try {
+            database = QuestDatabase::load(parser.value("db"));
+        } catch (const QException &) {
+            err << "Cannot read quest database " << parser.value("db") << "\n";
+            return 1;
+        }
+        const QString locale = parser.value("locale");
+        if (!database->locales().contains(locale))
+            err << "Language " << locale << " is not in the quest database, using enUS\n";
+
+        const int localeIndex = database->localeIndex(locale);
+
+        StatusWriter writer(out, format);
+        int failures = 0;
+
+        for (const QString &saveDir : saveDirs) {
+            QStringList characters = parser.values("character");
+            if (characters.isEmpty())
+                characters = findCharacters(saveDir);
+
+            for (const QString &character : characters) {
+                QuestData questData;
+                try {
+                    if (resolveQuestStatus(characterLevelsPath(saveDir, character), *database, localeIndex, questData) == 0) {
+                        err << "No quests files for " << character << " in " << saveDir << "\n";
+                        failures++;
+                        continue;
+                    }
+                } catch (const QException &) {
+                    err << "Cannot read the quests files of " << character << " in " << saveDir << "\n";
+                    failures++;
+                    continue;
+                }
+
+                writer.addCharacter(saveDir, character, questData);
+            }
+        }
+
+        writer.finish();
+        return failures > 0 ? 1 : 0;
+    }
+
+    int runVerify(const QCommandLineParser &parser, QTextStream &out, QTextStream &err)
+    {
+        const QStringList saveDirs = parser.values("saves");
+        if (saveDirs.isEmpty()) {
+            err << "verify needs at least one --saves directory\n";
+            return 2;
+        }
+
+        QuestsFile questsFile;
+        int checked = 0;
+        int failures = 0;
+
+        for (const QString &saveDir : saveDirs) {
+            QDirIterator it(saveDir, {"quests.gdd"}, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                const QString path = it.next();
+                checked++;
+
+                try {
+                    questsFile.read(path);
+                    out << "OK   " << path << "\n";
+                } catch (const QException &) {
+                    out << "FAIL " << path << "\n";
+                    failures++;
+                }
+            }
+        }
+
+        out.flush();
+        err << checked << " files checked, " << failures << " failed\n";
+        return failures > 0 ? 1 : 0;
+    }
+
+    int runGenerateDb(const QCommandLineParser &parser, QTextStream &err)
+    {
+        if (!parser.isSet("qst")) {
+            err << "generate-db needs a --qst directory\n";
+            return 2;
+        }
+
+        if (!generateQuestJson(parser.value("qst"), parser.value("output"))) {
+            err << "Cannot generate the quest database\n";
+            return 1;
+        }
+
+        return 0;
+    }
+
+    void printTimings(QTextStream &err)
+    {
+        err << "\nTimings (mean / max over the last " << PerfCounters::historySize << " samples):\n";
+        for (const PerfCounters::ZoneStats &zone : PerfCounters::zones()) {
+            err << QString("  %1 %2 x %3 ms / %4 ms").arg(zone.name, -28).arg(zone.count, 6)
+                       .arg(zone.meanNs / 1e6, 9, 'f', 3).arg(zone.maxNs / 1e6, 9, 'f', 3);
+            if (zone.megabytesPerSecond >= 0)
+                err << QString("  %1 MB/s").arg(zone.megabytesPerSecond, 0, 'f', 1);
+            err << "\n";
+        }
+
+        for (const PerfCounters::RatioStats &lookup : PerfCounters::lookups())
+            err << "  " << lookup.name << ": " << lookup.hits << " hits, " << lookup.misses << " misses\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gdqt_cli");
+
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless quest status dumps, save verification and quest database generation.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "status, verify or generate-db.");
+
+    QCommandLineOption savesOption("saves", "Save directory containing the character folders; repeatable.", "dir");
+    QCommandLineOption characterOption("character", "Only this character (status); repeatable. Default: all.", "name");
+    QCommandLineOption dbOption("db", "Quest database (status); a current quests.qcat next to it is used instead, the built-in database if it is missing.", "path", "resources/quests.json");
+    QCommandLineOption formatOption("format", "Output format of status: json, csv or ndjson.", "format", "json");
+    QCommandLineOption localeOption("locale", "Language of the chapter and quest names (status), e.g. deDE.", "tag", "enUS");
+    QCommandLineOption outputOption("output", "Write the status dump or the generated database to this file.", "path");
+    QCommandLineOption qstOption("qst", "Directory searched for .qst files and Quests.arc archives, or one .arc file (generate-db).", "path");
+    QCommandLineOption timingsOption("timings", "Print the timings of the parse stages to stderr.");
+    QCommandLineOption verboseOption("verbose", "Show debug output on stderr.");
+    parser.addOptions({savesOption, characterOption, dbOption, formatOption, localeOption, outputOption,
+                       qstOption, timingsOption, verboseOption});
+
+    parser.process(app);
+
+    verboseOutput = parser.isSet(verboseOption);
+    qInstallMessageHandler(messageHandler);
+
+    if (parser.isSet(timingsOption))
+        PerfCounters::setEnabled(true);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 1) {
+        err << "Expected exactly one command\n\n";
+        err.flush();
+        parser.showHelp(2);
+    }
+
+    const QString command = positional.first();
+
+    // The status dump goes to stdout unless --output is given; generate-db always uses --output
+    QFile outputFile;
+    if (command == "status" && parser.isSet(outputOption)) {
+        outputFile.setFileName(parser.value(outputOption));
+        if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            err << "Cannot write " << outputFile.fileName() << "\n";
+            return 1;
+        }
+    } else {
+        outputFile.open(stdout, QIODevice::WriteOnly);
+    }
+    QTextStream out(&outputFile);
+
+    int exitCode = 0;
+    if (command == "status") {
+        exitCode = runStatus(parser, out, err);
+    } else if (command == "verify") {
+        exitCode = runVerify(parser, out, err);
+    } else if (command == "generate-db") {
+        exitCode = runGenerateDb(parser, err);
+    } else {
+        err << "Unknown command: " << command << "\n";
+        exitCode = 2;
+    }
+
+    if (parser.isSet(timingsOption))
+        printTimings(err);
+
+    return exitCode;
+}
@@ -0,0 +1,204 @@
+#include "perfect_hash.h"
+#include "quest_catalog.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+namespace
+{
+    // Reads the quests like JsonParser does: lowercase keys, names in other languages under "Localized"
+    bool readQuests(const QByteArray& json, QMap<quint32, QuestInfo>& quests, QStringList& locales)
+    {
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(json, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject())
+            return false;
+
+        const QJsonObject root = doc.object();
+        for (auto it = root.begin(); it != root.end(); ++it) {
+            bool ok = false;
+            const quint32 hash = it.key().toLower().toUInt(&ok, 0);
+            if (!ok)
+                continue;
+
+            const QJsonObject questObj = it.value().toObject();
+            QuestInfo info;
+            info.Chapter = questObj.value("Chapter").toString();
+            info.QuestName = questObj.value("QuestName").toString();
+
+            const QJsonObject localizedObj = questObj.value("Localized").toObject();
+            for (auto locale = localizedObj.begin(); locale != localizedObj.end(); ++locale) {
+                const QJsonObject namesObj = locale.value().toObject();
+                info.Localized.insert(locale.key(), {namesObj.value("Chapter").toString(), namesObj.value("QuestName").toString()});
+                if (locale.key() != "enUS" && !locales.contains(locale.key()))
+                    locales.append(locale.key());
+            }
+
+            quests.insert(hash, info);
+        }
+
+        // English first, like in the catalog
+        locales.sort();
+        locales.prepend("enUS");
+        return true;
+    }
+
+    // A UTF-16 literal that only uses ASCII in the source, so the compiler's source charset does not matter
+    QString utf16Literal(const QString& text)
+    {
+        QString literal = "u\"";
+        for (uint code : text.toUcs4()) {
+            if (code == '"' || code == '\\') {
+                literal += '\\';
+                literal += QChar(code);
+            } else if (code >= 0x20 && code < 0x7f) {
+                literal += QChar(code);
+            } else if (code < 0xa0) {
+                // Control characters can't be universal character names; octal escapes are always 3 digits
+                literal += QString("\\%1").arg(code, 3, 8, QChar('0'));
+            } else if (code <= 0xffff) {
+                literal += QString("\\u%1").arg(code, 4, 16, QChar('0'));
+            } else {
+                literal += QString("\\U%1").arg(code, 8, 16, QChar('0'));
+            }
+        }
+        literal += '"';
+        return literal;
+    }
+
+    QString hexList(const QVector<quint32>& values)
+    {
+        QString list;
+        for (int i = 0; i < values.size(); i++) {
+            list += (i % 8 == 0) ? "\n        " : " ";
+            list += QString("0x%1,").arg(values[i], 8, 16, QChar('0'));
+        }
+        return list.isEmpty() ? QString("0") : list + "\n    ";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gdqt_embedgen");
+
+    QTextStream err(stderr);
+
+    const QStringList arguments = app.arguments();
+    if (arguments.size() != 3) {
+        err << "Usage: gdqt_embedgen <quests.json> <output header>" << Qt::endl;
+        return 2;
+    }
+
+    QFile jsonFile(arguments[1]);
+    if (!jsonFile.open(QIODevice::ReadOnly)) {
+        err << "Cannot read " << arguments[1] << Qt::endl;
+        return 1;
+    }
+    const QByteArray json = jsonFile.readAll();
+
+    QMap<quint32, QuestInfo> quests;
+    QStringList locales;
+    if (!readQuests(json, quests, locales)) {
+        err << "Invalid quest database " << arguments[1] << Qt::endl;
+        return 1;
+    }
+
+    QVector<quint32> keys;
+    for (auto it = quests.cbegin(); it != quests.cend(); ++it)
+        keys.append(it.key());
+
+    // Retry with more buckets in the unlikely case that a bucket finds no seed
+    QVector<quint32> seeds;
+    QVector<quint32> slotKeys;
+    quint32 bucketCount = quint32(qMax<int>(1, (int(keys.size()) + PerfectHash::keysPerBucket - 1) / PerfectHash::keysPerBucket));
+    while (!PerfectHash::build(keys, bucketCount, seeds, slotKeys))
+        bucketCount *= 2;
+
+    // Names are interned, so every chapter name is stored once
+    QStringList texts;
+    QHash<QString, int> textIndexes;
+    auto intern = [&](const QString& text) {
+        auto known = textIndexes.constFind(text);
+        if (known != textIndexes.constEnd())
+            return known.value();
+        const int index = int(texts.size());
+        textIndexes.insert(text, index);
+        texts.append(text);
+        return index;
+    };
+    intern(QString());
+
+    QVector<quint32> flags;
+    QString names;
+    for (quint32 key : std::as_const(slotKeys)) {
+        const QuestInfo& info = quests[key];
+        flags.append(QuestCatalog::flagsOf(info));
+
+        names += "\n        {";
+        for (const QString& locale : std::as_const(locales)) {
+            const LocalizedNames localized = QuestCatalog::namesOf(info, locale);
+            names += QString(" %1, %2,").arg(intern(localized.Chapter)).arg(intern(localized.QuestName));
+        }
+        names += " },";
+    }
+
+    QString localeList;
+    for (const QString& locale : std::as_const(locales))
+        localeList += QString(" \"%1\",").arg(locale);
+
+    QString textList;
+    for (const QString& text : std::as_const(texts))
+        textList += QString("\n        {%1, %2},").arg(utf16Literal(text)).arg(text.size());
+
+    QString header;
+    QTextStream out(&header);
+    out << "// Generated by gdqt_embedgen from quests.json; do not edit.\n"
+        << "#ifndef EMBEDDED_QUESTS_H\n"
+        << "#define EMBEDDED_QUESTS_H\n\n"
+        << "#include <QtGlobal>\n\n"
+        << "namespace EmbeddedQuests\n{\n"
+        << "    struct Text\n    {\n        const char16_t *data;\n        int size;\n    };\n\n"
+        << "    // The quests.json the data was generated from\n"
+        << "    constexpr qint64 sourceSize = " << json.size() << ";\n"
+        << "    constexpr char sourceMd5[] = \"" << QCryptographicHash::hash(json, QCryptographicHash::Md5).toHex() << "\";\n\n"
+        << "    constexpr int questCount = " << slotKeys.size() << ";\n"
+        << "    constexpr int localeCount = " << locales.size() << ";\n"
+        << "    constexpr const char *locales[localeCount] = {" << localeList << " };\n\n"
+        << "    // Seeds of the perfect hash buckets (see PerfectHash)\n"
+        << "    constexpr quint32 bucketCount = " << bucketCount << ";\n"
+        << "    constexpr quint32 seeds[bucketCount] = {" << hexList(seeds) << "};\n\n"
+        << "    // Quest hash and flags per slot of the perfect hash\n"
+        << "    constexpr quint32 hashes[] = {" << hexList(slotKeys) << "};\n"
+        << "    constexpr quint32 flags[] = {" << hexList(flags) << "};\n\n"
+        << "    // Text indexes of the chapter and quest name per slot and language\n"
+        << "    constexpr int names[][localeCount * 2] = {" << (names.isEmpty() ? QString(" { 0 }") : names + "\n    ") << "};\n\n"
+        << "    constexpr Text texts[] = {" << textList << "\n    };\n"
+        << "}\n\n"
+        << "#endif // EMBEDDED_QUESTS_H\n";
+    out.flush();
+
+    // Leave an unchanged header alone, so its dependents are not rebuilt
+    const QByteArray contents = header.toUtf8();
+    QFile existing(arguments[2]);
+    if (existing.open(QIODevice::ReadOnly) && existing.readAll() == contents)
+        return 0;
+    existing.close();
+
+    QSaveFile output(arguments[2]);
+    if (!output.open(QIODevice::WriteOnly) || output.write(contents) != contents.size() || !output.commit()) {
+        err << "Cannot write " << arguments[2] << Qt::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "gdd_parser.h"
+
+#include <QException>
+
+#include <cstdlib>
+
+namespace
+{
+    // The parser logs every header and failure, which would slow the fuzzer down to a crawl
+    void silentMessageHandler(QtMsgType, const QMessageLogContext&, const QString&) {}
+
+    // Counts what the streaming decoder reports, to compare it with the tree reader
+    class CountingVisitor : public QuestsVisitor
+    {
+    public:
+        void onToken(QLatin1String) override { tokens++; }
+        void onQuest(quint32, const UID&, quint32) override { quests++; }
+        void onTask(quint32, const UID&, quint32, quint32) override { tasks++; }
+        void onObjectives(const quint32*, quint32 count) override { objectives += count; }
+
+        qint64 tokens = 0;
+        qint64 quests = 0;
+        qint64 tasks = 0;
+        qint64 objectives = 0;
+    };
+}
+
+extern "C" int LLVMFuzzerInitialize(int*, char***)
+{
+    qInstallMessageHandler(silentMessageHandler);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    const uchar* bytes = reinterpret_cast<const uchar*>(data);
+
+    // Malformed input must end in a QException; anything else is a crash the fuzzer reports
+    bool readOk = false;
+    CountingVisitor expected;
+    try {
+        QuestsFile file;
+        file.readFromMemory(bytes, qint64(size));
+        readOk = true;
+
+        expected.tokens = file.tokens.tokens.size();
+        expected.quests = file.quests.quests.size();
+        for (const Quest& quest : std::as_const(file.quests.quests)) {
+            expected.tasks += quest.tasks.size();
+            for (const Task& task : quest.tasks)
+                expected.objectives += task.objectives.size();
+        }
+    } catch (const QException&) {
+    }
+
+    bool visitOk = false;
+    CountingVisitor visited;
+    try {
+        QuestsFile file;
+        file.visitFromMemory(bytes, qint64(size), visited);
+        visitOk = true;
+    } catch (const QException&) {
+    }
+
+    // Both decoders accept exactly the same files and see the same contents
+    if (readOk != visitOk || (readOk && (expected.tokens != visited.tokens || expected.quests != visited.quests
+                                         || expected.tasks != visited.tasks || expected.objectives != visited.objectives)))
+        std::abort();
+
+    return 0;
+}
@@ -0,0 +1,36 @@
+#include "qst_parser.h"
+
+#include <QByteArray>
+
+namespace
+{
+    // The parser logs every file it could not read, which would slow the fuzzer down to a crawl
+    void silentMessageHandler(QtMsgType, const QMessageLogContext&, const QString&) {}
+}
+
+extern "C" int LLVMFuzzerInitialize(int*, char***)
+{
+    qInstallMessageHandler(silentMessageHandler);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (size > size_t(QstFile::maxFileSize))
+        return 0;
+
+    // Parse the fuzzer's buffer in place; the parser only keeps it for the duration of the call
+    const QByteArray contents = QByteArray::fromRawData(reinterpret_cast<const char*>(data), int(size));
+
+    QstFile qst("fuzz.qst");
+    if (qst.parse(contents)) {
+        // Touch every result, so names that point outside the input are caught by AddressSanitizer
+        qsizetype length = qst.getChapterName().size() + qst.getQuestName().size();
+        const QMap<QString, QstLocalization> localizations = qst.getLocalizations();
+        for (const QstLocalization& localization : localizations)
+            length += localization.chapterName.size() + localization.questName.size();
+        Q_UNUSED(length);
+    }
+
+    return 0;
+}
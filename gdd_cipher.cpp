@@ -0,0 +1,206 @@
+#include "gdd_cipher.h"
+#include <QDebug>
+#include <QtEndian>
+
+#include <algorithm>
+
+// SSE2 is only part of the baseline on x86-64; 32-bit x86 builds use the scalar kernel
+#if defined(__GNUC__) && defined(__x86_64__)
+#define GDD_CIPHER_X86 1
+#define GDD_CIPHER_AVX2 1
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+// MSVC only gets the SSE2 kernel, which is part of the x64 baseline
+#define GDD_CIPHER_X86 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Combined table hash of the four raw bytes of one word
+    inline quint32 wordHash(const quint32* table, const uchar* p)
+    {
+        return table[p[0]] ^ table[p[1]] ^ table[p[2]] ^ table[p[3]];
+    }
+
+#ifdef GDD_CIPHER_X86
+    quint32 decryptWordsSse2(const quint32* table, quint32 key, const uchar* src, quint32* dst, quint32 count)
+    {
+        quint32 i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const uchar* p = src + i * 4;
+
+            // SSE2 has no gather, so the table hashes are collected with scalar loads
+            __m128i h = _mm_setr_epi32(int(wordHash(table, p)), int(wordHash(table, p + 4)),
+                                       int(wordHash(table, p + 8)), int(wordHash(table, p + 12)));
+
+            // Inclusive prefix-XOR of the four hashes
+            __m128i incl = _mm_xor_si128(h, _mm_slli_si128(h, 4));
+            incl = _mm_xor_si128(incl, _mm_slli_si128(incl, 8));
+
+            // The key in front of each word is the running key XORed with the exclusive prefix
+            __m128i keys = _mm_xor_si128(_mm_set1_epi32(int(key)), _mm_xor_si128(incl, h));
+            __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(raw, keys));
+
+            key ^= quint32(_mm_cvtsi128_si32(_mm_shuffle_epi32(incl, 0xFF)));
+        }
+
+        // Finish the tail with the reference loop
+        return GddCipher::decryptWordsScalar(table, key, src + i * 4, dst + i, count - i);
+    }
+#endif
+
+#ifdef GDD_CIPHER_AVX2
+    __attribute__((target("avx2")))
+    quint32 decryptWordsAvx2(const quint32* table, quint32 key, const uchar* src, quint32* dst, quint32 count)
+    {
+        const __m256i byteMask = _mm256_set1_epi32(0xFF);
+        const int* base = reinterpret_cast<const int*>(table);
+        quint32 i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+
+            // Gather the table entries of all four byte lanes of the eight words
+            __m256i h = _mm256_i32gather_epi32(base, _mm256_and_si256(raw, byteMask), 4);
+            h = _mm256_xor_si256(h, _mm256_i32gather_epi32(base, _mm256_and_si256(_mm256_srli_epi32(raw, 8), byteMask), 4));
+            h = _mm256_xor_si256(h, _mm256_i32gather_epi32(base, _mm256_and_si256(_mm256_srli_epi32(raw, 16), byteMask), 4));
+            h = _mm256_xor_si256(h, _mm256_i32gather_epi32(base, _mm256_srli_epi32(raw, 24), 4));
+
+            // Inclusive prefix-XOR inside each 128-bit lane...
+            __m256i incl = _mm256_xor_si256(h, _mm256_slli_si256(h, 4));
+            incl = _mm256_xor_si256(incl, _mm256_slli_si256(incl, 8));
+
+            // ...then carry the last element of the low lane into the high lane
+            __m256i last = _mm256_shuffle_epi32(incl, 0xFF);
+            incl = _mm256_xor_si256(incl, _mm256_permute2x128_si256(last, last, 0x08));
+
+            __m256i keys = _mm256_xor_si256(_mm256_set1_epi32(int(key)), _mm256_xor_si256(incl, h));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(raw, keys));
+
+            key ^= quint32(_mm256_extract_epi32(incl, 7));
+        }
+
+        // Finish the tail with the reference loop
+        return GddCipher::decryptWordsScalar(table, key, src + i * 4, dst + i, count - i);
+    }
+#endif
+
+    // Runs a candidate kernel over a deterministic pseudo-random buffer and compares it with the reference
+    bool matchesReference(GddCipher::DecryptFn candidate)
+    {
+        const quint32 words = 1021; // Odd length so the scalar tail is exercised as well
+        quint32 table[256];
+        uchar raw[words * 4];
+        quint32 expected[words];
+        quint32 actual[words];
+
+        quint32 state = 0x9E3779B9;
+        for (unsigned i = 0; i < 256; i++)
+        {
+            state = state * 1664525 + 1013904223;
+            table[i] = state;
+        }
+        for (unsigned i = 0; i < sizeof(raw); i++)
+        {
+            state = state * 1664525 + 1013904223;
+            raw[i] = uchar(state >> 24);
+        }
+
+        quint32 expectedKey = GddCipher::decryptWordsScalar(table, 0xDEADBEEF, raw, expected, words);
+        quint32 actualKey = candidate(table, 0xDEADBEEF, raw, actual, words);
+
+        return expectedKey == actualKey && std::equal(expected, expected + words, actual);
+    }
+
+    GddCipher::Kernel selectKernel()
+    {
+        const QVector<GddCipher::Kernel> candidates = GddCipher::kernels();
+
+        // Use the first kernel that reproduces the reference output bit-for-bit
+        for (const GddCipher::Kernel& candidate : candidates)
+        {
+            if (matchesReference(candidate.fn))
+                return candidate;
+
+            qWarning() << "GDD decryption kernel" << candidate.name << "failed self-check, skipping it.";
+        }
+
+        return candidates.last();
+    }
+
+    const GddCipher::Kernel& kernel()
+    {
+        static const GddCipher::Kernel selected = selectKernel();
+        return selected;
+    }
+}
+
+void GddCipher::buildTable(quint32 key, quint32* table)
+{
+    for (unsigned i = 0; i < 256; i++)
+    {
+        // Rotate the key right by 1 bit and multiply by a constant
+        key = (key >> 1) | (key << 31);
+        key *= 39916801;
+        // Store the transformed key in the table
+        table[i] = key;
+    }
+}
+
+quint32 GddCipher::decryptWordsScalar(const quint32* table, quint32 key, const uchar* src, quint32* dst, quint32 count)
+{
+    for (quint32 i = 0; i < count; i++)
+    {
+        const uchar* p = src + i * 4;
+
+        // Decrypt the word with the current key, then advance the key with the raw bytes
+        dst[i] = qFromLittleEndian<quint32>(p) ^ key;
+        key ^= wordHash(table, p);
+    }
+
+    return key;
+}
+
+quint32 GddCipher::decryptWords(const quint32* table, quint32 key, const uchar* src, quint32* dst, quint32 count)
+{
+    return kernel().fn(table, key, src, dst, count);
+}
+
+quint32 GddCipher::decryptBytes(const quint32* table, quint32 key, const uchar* src, quint8* dst, quint32 count)
+{
+    for (quint32 i = 0; i < count; i++)
+    {
+        // Decrypt the byte with the low byte of the key, then advance the key with the raw byte
+        dst[i] = quint8(src[i] ^ key);
+        key ^= table[src[i]];
+    }
+
+    return key;
+}
+
+QVector<GddCipher::Kernel> GddCipher::kernels()
+{
+    QVector<Kernel> available;
+
+#ifdef GDD_CIPHER_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        available.append({decryptWordsAvx2, "avx2"});
+#endif
+#ifdef GDD_CIPHER_X86
+    available.append({decryptWordsSse2, "sse2"});
+#endif
+
+    // The reference always works, so it is the last resort
+    available.append({decryptWordsScalar, "scalar"});
+    return available;
+}
+
+const char* GddCipher::kernelName()
+{
+    return kernel().name;
+}
@@ -0,0 +1,101 @@
+#ifndef GDD_CIPHER_H
+#define GDD_CIPHER_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @brief Bulk decryption kernels for the quests.gdd key schedule.
+ *
+ * Every 4-byte word of a GDD file is decrypted by XOR with the current key, after which the
+ * key is XORed with the table entries of the four raw bytes. Since the table index only
+ * depends on the raw (encrypted) data, the key in front of word @c i is the initial key XORed
+ * with a prefix-XOR of per-word table hashes. That prefix can be computed as a data-parallel
+ * scan, which is what the SIMD kernels below do.
+ *
+ * The kernel is picked once at runtime (AVX2 or SSE2 on x86-64, scalar elsewhere) and verified
+ * bit-for-bit against the scalar reference before it is used.
+ */
+namespace GddCipher
+{
+    /// Constant the stored file key is XORed with to obtain the actual key.
+    constexpr quint32 keyMask = 0x55555555;
+
+    /// Signature shared by all word decryption kernels (see @ref decryptWordsScalar).
+    typedef quint32 (*DecryptFn)(const quint32* table, quint32 key, const uchar* src, quint32* dst, quint32 count);
+
+    /**
+     * @brief A word decryption kernel and its name.
+     */
+    struct Kernel
+    {
+        DecryptFn fn;
+        const char* name;
+    };
+
+    /**
+     * @brief Builds the 256-entry key table derived from the file key.
+     *
+     * @param key The actual (unmasked) file key.
+     * @param table Receives the 256 table entries.
+     */
+    void buildTable(quint32 key, quint32* table);
+
+    /**
+     * @brief Decrypts a run of 4-byte words with the reference (serial) algorithm.
+     *
+     * @param table The 256-entry key table built from the file key.
+     * @param key The key in effect before the first word.
+     * @param src Pointer to @p count raw little-endian words.
+     * @param dst Receives the @p count decrypted words.
+     * @param count Number of words to decrypt.
+     * @return The key in effect after the last word.
+     */
+    quint32 decryptWordsScalar(const quint32* table, quint32 key, const uchar* src, quint32* dst, quint32 count);
+
+    /**
+     * @brief Decrypts a run of 4-byte words with the fastest kernel available on this CPU.
+     *
+     * Produces exactly the same output and final key as @ref decryptWordsScalar.
+     *
+     * @param table The 256-entry key table built from the file key.
+     * @param key The key in effect before the first word.
+     * @param src Pointer to @p count raw little-endian words.
+     * @param dst Receives the @p count decrypted words.
+     * @param count Number of words to decrypt.
+     * @return The key in effect after the last word.
+     */
+    quint32 decryptWords(const quint32* table, quint32 key, const uchar* src, quint32* dst, quint32 count);
+
+    /**
+     * @brief Decrypts a run of single bytes.
+     *
+     * Each byte is XORed with the low byte of the current key, after which the key is advanced
+     * with the table entry of the raw byte, exactly as a sequence of single-byte reads would.
+     *
+     * @param table The 256-entry key table built from the file key.
+     * @param key The key in effect before the first byte.
+     * @param src Pointer to @p count raw bytes.
+     * @param dst Receives the @p count decrypted bytes.
+     * @param count Number of bytes to decrypt.
+     * @return The key in effect after the last byte.
+     */
+    quint32 decryptBytes(const quint32* table, quint32 key, const uchar* src, quint8* dst, quint32 count);
+
+    /**
+     * @brief Returns every word kernel built in and supported by this CPU, fastest first.
+     *
+     * The scalar reference is always the last entry. Unlike @ref decryptWords, this does not
+     * self-check the kernels, so tests can compare each of them against the reference.
+     */
+    QVector<Kernel> kernels();
+
+    /**
+     * @brief Returns the name of the kernel selected by @ref decryptWords.
+     *
+     * @return "avx2", "sse2" or "scalar".
+     */
+    const char* kernelName();
+}
+
+#endif // GDD_CIPHER_H
@@ -0,0 +1,117 @@
+#include "gdd_cipher.h"
+
+#include <QByteArray>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+#include <QtEndian>
+
+namespace
+{
+    /**
+     * @brief The key schedule as QuestsFile::readInt/readByte originally applied it, one value at a time.
+     */
+    struct ReferenceReader
+    {
+        const quint32* table;
+        quint32 key;
+
+        quint32 readInt(const uchar* p)
+        {
+            // Decrypt with the current key, then advance the key with each raw byte
+            quint32 ret = qFromLittleEndian<quint32>(p) ^ key;
+            for (unsigned i = 0; i < 4; i++)
+                key ^= table[p[i]];
+            return ret;
+        }
+
+        quint8 readByte(const uchar* p)
+        {
+            quint8 ret = quint8(*p ^ key);
+            key ^= table[*p];
+            return ret;
+        }
+    };
+
+    int failures = 0;
+
+    void check(bool ok, const QString& what)
+    {
+        if (ok)
+            return;
+
+        QTextStream(stderr) << "FAIL: " << what << Qt::endl;
+        failures++;
+    }
+}
+
+int main()
+{
+    QTextStream out(stdout);
+    QRandomGenerator rng(20241017);
+
+    const QVector<GddCipher::Kernel> kernels = GddCipher::kernels();
+    out << "Kernels:";
+    for (const GddCipher::Kernel& kernel : kernels)
+        out << " " << kernel.name;
+    out << ", selected " << GddCipher::kernelName() << Qt::endl;
+
+    // Every length up to a few SIMD blocks, then odd lengths with long vector runs and short tails
+    QVector<quint32> lengths;
+    for (quint32 n = 0; n <= 67; n++)
+        lengths.append(n);
+    lengths << 255 << 1021 << 4097 << 65537;
+
+    quint32 table[256];
+    int cases = 0;
+
+    for (int round = 0; round < 8; round++) {
+        GddCipher::buildTable(rng.generate(), table);
+
+        for (quint32 words : std::as_const(lengths)) {
+            // Unaligned sources as well, since the kernels load raw words from anywhere in the file
+            for (int misalign = 0; misalign < 4; misalign++) {
+                QByteArray buffer(int(words * 4) + misalign, Qt::Uninitialized);
+                for (char& c : buffer)
+                    c = char(rng.bounded(256));
+                const uchar* src = reinterpret_cast<const uchar*>(buffer.constData()) + misalign;
+                const quint32 startKey = rng.generate();
+
+                ReferenceReader reference{table, startKey};
+                QVector<quint32> expected(words);
+                for (quint32 i = 0; i < words; i++)
+                    expected[int(i)] = reference.readInt(src + i * 4);
+
+                for (const GddCipher::Kernel& kernel : kernels) {
+                    QVector<quint32> actual(words);
+                    const quint32 key = kernel.fn(table, startKey, src, actual.data(), words);
+
+                    const QString what = QString("%1, %2 words, offset %3, round %4").arg(kernel.name).arg(words).arg(misalign).arg(round);
+                    check(actual == expected, what + ": decrypted words differ");
+                    check(key == reference.key, what + ": final key differs");
+                    cases++;
+                }
+
+                // The selected kernel and the byte decoder go through the public entry points
+                QVector<quint32> selected(words);
+                check(GddCipher::decryptWords(table, startKey, src, selected.data(), words) == reference.key && selected == expected,
+                      QString("decryptWords, %1 words").arg(words));
+
+                const quint32 bytes = words * 4 + quint32(misalign);
+                ReferenceReader byteReference{table, startKey};
+                QByteArray expectedBytes(int(bytes), Qt::Uninitialized);
+                for (quint32 i = 0; i < bytes; i++)
+                    expectedBytes[int(i)] = char(byteReference.readByte(reinterpret_cast<const uchar*>(buffer.constData()) + i));
+
+                QByteArray actualBytes(int(bytes), Qt::Uninitialized);
+                const quint32 byteKey = GddCipher::decryptBytes(table, startKey, reinterpret_cast<const uchar*>(buffer.constData()),
+                                                                reinterpret_cast<quint8*>(actualBytes.data()), bytes);
+                check(actualBytes == expectedBytes && byteKey == byteReference.key, QString("decryptBytes, %1 bytes").arg(bytes));
+                cases++;
+            }
+        }
+    }
+
+    out << cases << " cases, " << failures << " failures" << Qt::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include "gdd_generator.h"
+#include "gdd_writer.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QRandomGenerator>
+
+#include <cstring>
+
+namespace
+{
+    void randomUid(QRandomGenerator& rng, UID& uid)
+    {
+        for (unsigned i = 0; i < 16; i++)
+            uid.id[i] = quint8(rng.bounded(256));
+    }
+
+    bool sameUid(const UID& a, const UID& b)
+    {
+        return std::memcmp(a.id, b.id, sizeof(a.id)) == 0;
+    }
+}
+
+void GddGenerator::generate(const SyntheticSaveOptions& options, QuestsFile& file)
+{
+    // QRandomGenerator gives the same sequence for the same seed on every platform
+    QRandomGenerator rng(options.seed);
+
+    randomUid(rng, file.id);
+
+    // Tokens look like the game's internal flags: an upper-case prefix plus a variable-length tail
+    file.tokens.tokens.resize(options.tokens);
+    for (quint32 i = 0; i < options.tokens; i++) {
+        QString token = QString("SYN_TOKEN_%1_").arg(i);
+        quint32 tail = rng.bounded(24u);
+        for (quint32 c = 0; c < tail; c++)
+            token.append(QChar('A' + rng.bounded(26)));
+        static_cast<QString&>(file.tokens.tokens[i]) = token;
+    }
+
+    file.quests.quests.resize(options.quests);
+    for (quint32 q = 0; q < options.quests; q++) {
+        Quest& quest = file.quests.quests[q];
+
+        quest.id1 = options.questIds.isEmpty() ? rng.generate() : options.questIds[q % options.questIds.size()];
+        randomUid(rng, quest.id2);
+
+        // Pick an overall outcome so the file contains completed, untouched and in-progress quests
+        quint32 outcome = rng.bounded(10u);
+        quint32 taskCount = 1 + rng.bounded(qMax(options.tasksPerQuest, 1u));
+
+        quest.tasks.resize(taskCount);
+        for (quint32 t = 0; t < taskCount; t++) {
+            Task& task = quest.tasks[t];
+
+            task.id1 = rng.generate();
+            randomUid(rng, task.id2);
+
+            if (outcome < 4) {
+                task.state = 3;                      // Completed
+            } else if (outcome < 7) {
+                task.state = rng.bounded(2u);        // Not started
+            } else {
+                task.state = rng.bounded(4u);        // Mixed, in progress
+            }
+            task.inProgress = task.state == 2 ? 1 : 0;
+
+            task.objectives.resize(rng.bounded(options.objectivesPerTask + 1));
+            for (quint32& objective : task.objectives)
+                objective = rng.bounded(16u);
+        }
+    }
+}
+
+QByteArray GddGenerator::generateBytes(const SyntheticSaveOptions& options)
+{
+    QuestsFile file;
+    generate(options, file);
+
+    QuestsFileWriter writer(fileKeyForSeed(options.seed));
+    return writer.encode(file);
+}
+
+bool GddGenerator::generateSaveTree(const QString& root, quint32 characters, const SyntheticSaveOptions& options)
+{
+    static const char* const difficulties[] = {"Normal", "Elite", "Ultimate"};
+
+    for (quint32 c = 0; c < characters; c++) {
+        for (int d = 0; d < 3; d++) {
+            QString dirPath = QString("%1/_Synthetic%2/levels_world001.map/%3")
+                                  .arg(root)
+                                  .arg(c, 3, 10, QChar('0'))
+                                  .arg(difficulties[d]);
+
+            if (!QDir().mkpath(dirPath)) {
+                qWarning() << "Could not create directory:" << dirPath;
+                return false;
+            }
+
+            // Every file gets its own seed so characters and difficulties differ
+            SyntheticSaveOptions fileOptions = options;
+            fileOptions.seed = options.seed + c * 3 + quint32(d);
+
+            QuestsFile file;
+            generate(fileOptions, file);
+
+            QuestsFileWriter writer(fileKeyForSeed(fileOptions.seed));
+            if (!writer.write(file, dirPath + "/quests.gdd"))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+quint32 GddGenerator::fileKeyForSeed(quint32 seed)
+{
+    // Derive the file key from the seed so different files don't share a key table
+    return seed * 2654435761u + 0x2A6F1C35;
+}
+
+bool GddGenerator::verifyRoundTrip(const QuestsFile& file, quint32 fileKey, QString* error)
+{
+    QuestsFileWriter writer(fileKey);
+    QByteArray bytes = writer.encode(file);
+
+    QuestsFile decoded;
+    try {
+        decoded.readFromMemory(reinterpret_cast<const uchar*>(bytes.constData()), bytes.size());
+    } catch (QException&) {
+        if (error)
+            *error = "Encoded file could not be decoded";
+        return false;
+    }
+
+    return sameContents(file, decoded, error);
+}
+
+bool GddGenerator::sameContents(const QuestsFile& expected, const QuestsFile& actual, QString* error)
+{
+    auto fail = [error](const QString& message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    if (!sameUid(actual.id, expected.id))
+        return fail("File UID differs");
+
+    if (actual.tokens.tokens != expected.tokens.tokens)
+        return fail("Token list differs");
+
+    if (actual.quests.quests.size() != expected.quests.quests.size())
+        return fail("Quest count differs");
+
+    for (int q = 0; q < expected.quests.quests.size(); q++) {
+        const Quest& a = expected.quests.quests[q];
+        const Quest& b = actual.quests.quests[q];
+
+        if (a.id1 != b.id1 || !sameUid(a.id2, b.id2) || a.tasks.size() != b.tasks.size())
+            return fail(QString("Quest %1 differs").arg(q));
+
+        for (int t = 0; t < a.tasks.size(); t++) {
+            const Task& x = a.tasks[t];
+            const Task& y = b.tasks[t];
+
+            if (x.id1 != y.id1 || !sameUid(x.id2, y.id2) || x.state != y.state
+                || x.inProgress != y.inProgress || x.objectives != y.objectives)
+                return fail(QString("Task %1 of quest %2 differs").arg(t).arg(q));
+        }
+    }
+
+    return true;
+}
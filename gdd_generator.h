@@ -0,0 +1,96 @@
+#ifndef GDD_GENERATOR_H
+#define GDD_GENERATOR_H
+
+#include "gdd_parser.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Parameters of a synthetic quests.gdd file.
+ *
+ * Generation is fully determined by these options, so the same options always produce the same
+ * file on every platform.
+ */
+struct SyntheticSaveOptions
+{
+    /// Seed of the pseudo-random generator.
+    quint32 seed = 1;
+    /// Number of quests in the file.
+    quint32 quests = 200;
+    /// Maximum number of tasks per quest; each quest gets between 1 and this many.
+    quint32 tasksPerQuest = 4;
+    /// Maximum number of objectives per task; each task gets between 0 and this many.
+    quint32 objectivesPerTask = 2;
+    /// Number of tokens in the token list.
+    quint32 tokens = 50;
+    /// Quest identifiers to draw from (e.g. hashes of a quest database); random ids if empty.
+    QVector<quint32> questIds;
+};
+
+/**
+ * @brief Produces deterministic synthetic quests files and save trees.
+ *
+ * Used to benchmark the parser at any scale and to validate fast decoding paths without
+ * playing the game.
+ */
+namespace GddGenerator
+{
+    /**
+     * @brief Fills a QuestsFile with synthetic tokens and quests.
+     *
+     * @param options Parameters of the synthetic data.
+     * @param file Receives the generated id, tokens and quests.
+     */
+    void generate(const SyntheticSaveOptions& options, QuestsFile& file);
+
+    /**
+     * @brief Generates a synthetic quests file and returns its encrypted contents.
+     *
+     * @param options Parameters of the synthetic data.
+     * @return The raw file contents, readable by QuestsFile.
+     */
+    QByteArray generateBytes(const SyntheticSaveOptions& options);
+
+    /**
+     * @brief Writes a fake save tree with @p characters characters and all three difficulties.
+     *
+     * Files are placed at root/_SyntheticNNN/levels_world001.map/{Normal,Elite,Ultimate}/quests.gdd,
+     * the layout expected by Settings::getAvailableCharacters. Every file uses its own seed
+     * derived from @p options.
+     *
+     * @param root Directory that becomes the save root; created if missing.
+     * @param characters Number of characters to generate.
+     * @param options Parameters of the synthetic data.
+     * @return True if every file was written successfully; otherwise false.
+     */
+    bool generateSaveTree(const QString& root, quint32 characters, const SyntheticSaveOptions& options);
+
+    /**
+     * @brief Returns the file key that @ref generateBytes and @ref generateSaveTree use for a seed.
+     */
+    quint32 fileKeyForSeed(quint32 seed);
+
+    /**
+     * @brief Encodes a quests file, decodes it again and compares the structures.
+     *
+     * @param file The quests file to round-trip.
+     * @param fileKey The actual (unmasked) key to encrypt the file with.
+     * @param error Receives a description of the first difference, if any.
+     * @return True if the decoded data is identical to @p file.
+     */
+    bool verifyRoundTrip(const QuestsFile& file, quint32 fileKey, QString* error = nullptr);
+
+    /**
+     * @brief Compares the id, tokens, quests, tasks and objectives of two quests files.
+     *
+     * @param expected The reference data.
+     * @param actual The data to check.
+     * @param error Receives a description of the first difference, if any.
+     * @return True if both files hold the same data.
+     */
+    bool sameContents(const QuestsFile& expected, const QuestsFile& actual, QString* error = nullptr);
+}
+
+#endif // GDD_GENERATOR_H
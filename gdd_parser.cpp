@@ -1,5 +1,61 @@
 #include "gdd_parser.h"
+#include "gdd_cipher.h"
+#include "trace.h"
 #include <QDebug>
+#include <QScopeGuard>
+#include <QtEndian>
+
+#include <algorithm>
+
+namespace
+{
+    // Appends streamed quests straight into the flat arrays
+    class FlatQuestListBuilder : public QuestsVisitor
+    {
+    public:
+        FlatQuestListBuilder(FlatQuestList& list, bool includeTokens) : m_list(list), m_includeTokens(includeTokens) {}
+
+        bool wantsTokens() const override { return m_includeTokens; }
+
+        void onToken(QLatin1String token) override
+        {
+            m_list.tokenOffsets.push_back(quint32(m_list.tokenChars.size()));
+            m_list.tokenChars.insert(m_list.tokenChars.end(), token.data(), token.data() + token.size());
+        }
+
+        void onQuestCount(quint32 count) override
+        {
+            m_list.questIds.reserve(count);
+            m_list.questUids.reserve(count);
+            m_list.questTaskOffsets.reserve(count + 1);
+        }
+
+        void onQuest(quint32 id1, const UID& id2, quint32) override
+        {
+            m_list.questIds.push_back(id1);
+            m_list.questUids.push_back(id2);
+            m_list.questTaskOffsets.push_back(m_list.taskCount());
+        }
+
+        void onTask(quint32 id1, const UID& id2, quint32 state, quint32 inProgress) override
+        {
+            m_list.taskIds.push_back(id1);
+            m_list.taskUids.push_back(id2);
+            m_list.taskStates.push_back(state);
+            m_list.taskInProgress.push_back(quint8(inProgress));
+            m_list.taskObjectiveOffsets.push_back(quint32(m_list.objectives.size()));
+        }
+
+        void onObjectives(const quint32* objectives, quint32 count) override
+        {
+            m_list.objectives.insert(m_list.objectives.end(), objectives, objectives + count);
+        }
+
+    private:
+        FlatQuestList& m_list;
+        bool m_includeTokens;
+    };
+}
 
 template <typename T>
 void Vector<T>::read(QuestsFile* gdd)
@@ -7,40 +63,68 @@ void Vector<T>::read(QuestsFile* gdd)
     // Read the number of elements in the vector from the file
     quint32 n = gdd->readInt();
 
+    // Reject counts that cannot fit in the remaining data before allocating anything
+    gdd->checkCount(n, GddElementTraits<T>::minEncodedSize);
+
+    // Read the elements themselves
+    readElements(gdd, n);
+}
+
+template <typename T>
+void Vector<T>::readElements(QuestsFile* gdd, quint32 n)
+{
     // Resize the vector to hold 'n' elements
     this->resize(n);
 
-    // Iterate over each element and read its data from the file
-    for (quint32 i = 0; i < n; i++)
-    {
-        // Recursively call the read function of each element
-        (*this)[i].read(gdd);
+    if constexpr (GddElementTraits<T>::isBulkDecodable) {
+        // Fixed-width elements are decrypted as a single run
+        GddElementTraits<T>::readRun(gdd, this->data(), n);
+    } else {
+        // Iterate over each element and read its data from the file
+        for (quint32 i = 0; i < n; i++)
+        {
+            // Recursively call the read function of each element
+            (*this)[i].read(gdd);
+        }
     }
 }
 
+void GddElementTraits<quint32>::readRun(QuestsFile* gdd, quint32* out, quint32 count)
+{
+    gdd->decryptSpan(out, count);
+}
+
+void GddElementTraits<quint8>::readRun(QuestsFile* gdd, quint8* out, quint32 count)
+{
+    gdd->decryptBytes(out, count);
+}
+
+void GddElementTraits<UID>::readRun(QuestsFile* gdd, UID* out, quint32 count)
+{
+    static_assert(sizeof(UID) == 16, "UID must be exactly 16 plain bytes");
+
+    // Consecutive UIDs are one contiguous byte run
+    gdd->decryptBytes(reinterpret_cast<quint8*>(out), count * quint32(sizeof(UID)));
+}
+
 void String::read(QuestsFile* gdd)
 {
-    // Read the length of the string from the file
+    // Read the length of the string from the file and make sure the data is actually there
     quint32 len = gdd->readInt();
+    gdd->checkCount(len, 1);
 
-    // Clear any existing content in the string
-    this->clear();
+    // Decrypt all characters in one pass into a scratch buffer (on the stack for typical lengths)
+    QVarLengthArray<quint8, 256> buffer(len);
+    gdd->decryptBytes(buffer.data(), len);
 
-    // Read 'len' bytes from the file and append them to the string
-    for (quint32 i = 0; i < len; i++)
-    {
-        // Read a byte and convert it to a QChar before appending
-        this->append(QChar(gdd->readByte()));
-    }
+    // Build the string with a single Latin-1 conversion instead of appending per character
+    QString::operator=(QString::fromLatin1(reinterpret_cast<const char*>(buffer.constData()), len));
 }
 
 void UID::read(QuestsFile* gdd)
 {
-    // A UID consists of 16 bytes; read each byte from the file
-    for (unsigned i = 0; i < 16; i++)
-    {
-        id[i] = gdd->readByte();
-    }
+    // A UID consists of 16 bytes; decrypt them in one pass
+    gdd->decryptBytes(id, 16);
 }
 
 void TokenList::read(QuestsFile* gdd)
@@ -132,22 +216,149 @@ void Task::read(QuestsFile* gdd)
 
     // Calculate the number of objectives based on the remaining block length
     // Each objective is a 4-byte integer, and we've already read 6 bytes (state, inProgress, padding)
+    if (b.len < 6)
+        throw QException(); // A task block can't be shorter than its fixed fields
     quint32 n = (b.len - 6) / 4;
 
-    // Resize the objectives vector to hold 'n' objectives
-    objectives.resize(n);
-
-    // Read each objective's data from the file
-    for (quint32 i = 0; i < n; i++)
-    {
-        objectives[i] = gdd->readInt();
-    }
+    // Read all objectives; as a vector of 4-byte integers they are decrypted in a single pass
+    objectives.readElements(gdd, n);
 
     // Ensure we've reached the end of the block without extra data
     gdd->readBlockEnd(&b);
 }
 
+FlatQuestList::FlatQuestList(std::pmr::memory_resource* resource)
+    : questIds(resource)
+    , questUids(resource)
+    , questTaskOffsets(resource)
+    , taskIds(resource)
+    , taskUids(resource)
+    , taskStates(resource)
+    , taskInProgress(resource)
+    , taskObjectiveOffsets(resource)
+    , objectives(resource)
+    , tokenChars(resource)
+    , tokenOffsets(resource)
+{
+}
+
+void FlatQuestList::clear()
+{
+    // Clearing keeps the capacity, so a reused list does not reallocate
+    questIds.clear();
+    questUids.clear();
+    questTaskOffsets.clear();
+    taskIds.clear();
+    taskUids.clear();
+    taskStates.clear();
+    taskInProgress.clear();
+    taskObjectiveOffsets.clear();
+    objectives.clear();
+    tokenChars.clear();
+    tokenOffsets.clear();
+}
+
+QLatin1String FlatQuestList::token(quint32 index) const
+{
+    quint32 begin = tokenOffsets[index];
+    return QLatin1String(tokenChars.data() + begin, int(tokenOffsets[index + 1] - begin));
+}
+
+bool FlatQuestList::allTasksInState(quint32 quest, quint32 state) const
+{
+    const quint32* begin = taskStates.data() + questTaskOffsets[quest];
+    const quint32* end = taskStates.data() + questTaskOffsets[quest + 1];
+
+    return std::all_of(begin, end, [state](quint32 s) { return s == state; });
+}
+
+bool FlatQuestList::anyTaskInState(quint32 quest, quint32 state) const
+{
+    const quint32* begin = taskStates.data() + questTaskOffsets[quest];
+    const quint32* end = taskStates.data() + questTaskOffsets[quest + 1];
+
+    return std::any_of(begin, end, [state](quint32 s) { return s == state; });
+}
+
 void QuestsFile::read(const QString& filename)
+{
+    TraceZone zone("QuestsFile::read");
+
+    withFileContents(filename, [this, &zone](const uchar* bytes, qint64 length) {
+        readFromMemory(bytes, length);
+
+        zone.setBytes(length);
+        zone.setItems(quests.quests.size());
+    });
+}
+
+void QuestsFile::readFromMemory(const uchar* bytes, qint64 length)
+{
+    // Make sure the cursor never outlives this call, even if decoding fails
+    auto resetCursor = qScopeGuard([this] { endDecode(); });
+
+    // Read the key, header and file UID
+    beginDecode(bytes, length);
+
+    // Read the list of tokens used in the quests
+    tokens.read(this);
+
+    // Read the list of quests from the file
+    quests.read(this);
+
+    // Verify that we've reached the end of the file
+    if (pos != size) {
+        qCritical() << "File read did not reach expected end position. Current position:" << pos << ", Expected:" << size;
+        throw QException();
+    }
+}
+
+void QuestsFile::visit(const QString& filename, QuestsVisitor& visitor)
+{
+    TraceZone zone("QuestsFile::visit");
+
+    withFileContents(filename, [this, &visitor, &zone](const uchar* bytes, qint64 length) {
+        visitFromMemory(bytes, length, visitor);
+
+        zone.setBytes(length);
+        zone.setItems(visitedQuests);
+    });
+}
+
+void QuestsFile::visitFromMemory(const uchar* bytes, qint64 length, QuestsVisitor& visitor)
+{
+    // Make sure the cursor never outlives this call, even if decoding fails
+    auto resetCursor = qScopeGuard([this] { endDecode(); });
+
+    // Read the key, header and file UID
+    beginDecode(bytes, length);
+
+    // Stream the token and quest blocks through the visitor
+    visitTokens(visitor);
+    visitQuests(visitor);
+
+    // Verify that we've reached the end of the file
+    if (pos != size) {
+        qCritical() << "File read did not reach expected end position. Current position:" << pos << ", Expected:" << size;
+        throw QException();
+    }
+}
+
+void QuestsFile::readFlat(const QString& filename, FlatQuestList& list, bool includeTokens)
+{
+    list.clear();
+
+    FlatQuestListBuilder builder(list, includeTokens);
+    visit(filename, builder);
+
+    // Close the offset arrays so every quest, task and token has an end index
+    list.questTaskOffsets.push_back(list.taskCount());
+    list.taskObjectiveOffsets.push_back(quint32(list.objectives.size()));
+    if (includeTokens)
+        list.tokenOffsets.push_back(quint32(list.tokenChars.size()));
+}
+
+void QuestsFile::withFileContents(const QString& filename, const std::function<void(const uchar*, qint64)>& decode)
 {
     QFile f(filename);
     // Attempt to open the file in read-only mode
@@ -158,17 +369,42 @@ void QuestsFile::read(const QString& filename)
 
     qDebug() << "Opened file:" << filename;
 
-    // Initialize the file and data stream
-    file = &f;
-    stream = new QDataStream(file);
-
-    // Set the byte order to Little Endian as per file format specification
-    stream->setByteOrder(QDataStream::LittleEndian);
-
     // Get the size of the file to determine the end position
-    qint64 end = file->size();
+    qint64 end = f.size();
     qDebug() << "File size:" << end << "bytes";
 
+    // Refuse files that can't be a quests file before mapping or buffering them
+    if (end > maxFileSize) {
+        qCritical() << "File is too large to be a quests file:" << filename;
+        throw QException();
+    }
+
+    // Map the whole file into memory; the mapping is released when the file is closed,
+    // so an exception thrown while decoding cannot leak it
+    const uchar* mapped = end > 0 ? f.map(0, end) : nullptr;
+
+    // Fall back to a single buffered read if the file system does not support mapping
+    QByteArray buffer;
+    if (!mapped) {
+        buffer = f.readAll();
+        if (buffer.size() != end) {
+            qCritical() << "Failed to read file:" << filename;
+            throw QException();
+        }
+        mapped = reinterpret_cast<const uchar*>(buffer.constData());
+    }
+
+    decode(mapped, end);
+}
+
+void QuestsFile::beginDecode(const uchar* bytes, qint64 length)
+{
+    // Point the cursor at the file contents
+    data = bytes;
+    size = length;
+    pos = 0;
+    limit = length;
+
     // Read the encryption key used for subsequent data decryption
     readKey();
     qDebug() << "Read key successfully.";
@@ -195,65 +431,160 @@ void QuestsFile::read(const QString& filename)
 
     // Read the unique identifier for the file
     id.read(this);
+}
 
-    // Read the list of tokens used in the quests
-    tokens.read(this);
+void QuestsFile::endDecode()
+{
+    // Release the cursor; the buffer is owned by the caller
+    data = nullptr;
+    size = 0;
+    pos = 0;
+    limit = 0;
+}
 
-    // Read the list of quests from the file
-    quests.read(this);
+void QuestsFile::visitTokens(QuestsVisitor& visitor)
+{
+    Block b;
 
-    // Verify that we've reached the end of the file
-    if (file->pos() != end) {
-        qCritical() << "File read did not reach expected end position. Current position:" << file->pos() << ", Expected:" << end;
-        throw QException();
+    // Begin reading a block and check if the block type is 10 (TokenList)
+    if (readBlockStart(&b) != 10)
+        throw QException(); // Throw an exception if the block type doesn't match
+
+    // Read the version number of the TokenList and verify it
+    if (readInt() != 2)
+        throw QException(); // Expected version is 2
+
+    const bool wanted = visitor.wantsTokens();
+    QVarLengthArray<quint8, 256> buffer;
+
+    // Decode each token into a reusable scratch buffer, or just advance the key over it
+    quint32 n = readInt();
+    checkCount(n, GddElementTraits<String>::minEncodedSize);
+
+    for (quint32 i = 0; i < n; i++)
+    {
+        quint32 len = readInt();
+        checkCount(len, 1);
+
+        if (wanted) {
+            buffer.resize(len);
+            decryptBytes(buffer.data(), len);
+            visitor.onToken(QLatin1String(reinterpret_cast<const char*>(buffer.constData()), len));
+        } else {
+            skipBytes(len);
+        }
     }
 
-    // Clean up by deleting the stream and resetting pointers
-    delete stream;
-    stream = nullptr;
-    file = nullptr;
+    // Ensure we've reached the end of the block without extra data
+    readBlockEnd(&b);
 }
 
-void QuestsFile::readKey()
+void QuestsFile::visitQuests(QuestsVisitor& visitor)
 {
-    quint32 k;
+    Block b;
 
-    // Read the initial key value from the file (4 bytes)
-    if (stream->readRawData(reinterpret_cast<char*>(&k), sizeof(k)) != sizeof(k))
-        throw QException(); // Throw an exception if reading fails
+    // Begin reading a block and check if the block type is 11 (QuestList) with version 4
+    if (readBlockStart(&b) != 11)
+        throw QException();
 
-    // XOR the key with a constant value to get the actual key
-    k ^= 0x55555555;
-    key = k;
+    if (readInt() != 4)
+        throw QException();
 
-    // Initialize the key table used for decrypting subsequent data
-    for (unsigned i = 0; i < 256; i++)
+    const bool wantsObjectives = visitor.wantsObjectives();
+    QVarLengthArray<quint32, 64> objectives;
+
+    quint32 questCount = readInt();
+    checkCount(questCount, GddElementTraits<Quest>::minEncodedSize);
+    visitor.onQuestCount(questCount);
+    visitedQuests = questCount;
+
+    for (quint32 q = 0; q < questCount; q++)
     {
-        // Rotate the key right by 1 bit and multiply by a constant
-        k = (k >> 1) | (k << 31);
-        k *= 39916801;
-        // Store the transformed key in the table
-        table[i] = k;
+        Block questBlock;
+        UID questUid;
+
+        // Quest identifiers precede the quest block, mirroring Quest::read
+        quint32 questId = readInt();
+        questUid.read(this);
+
+        if (readBlockStart(&questBlock))
+            throw QException();
+
+        quint32 taskCount = readInt();
+        checkCount(taskCount, GddElementTraits<Task>::minEncodedSize);
+        visitor.onQuest(questId, questUid, taskCount);
+
+        for (quint32 t = 0; t < taskCount; t++)
+        {
+            Block taskBlock;
+            UID taskUid;
+
+            // Task identifiers precede the task block, mirroring Task::read
+            quint32 taskId = readInt();
+            taskUid.read(this);
+
+            if (readBlockStart(&taskBlock) != 0)
+                throw QException();
+
+            // Read the state, the in-progress flag and the padding byte
+            quint32 state = readInt();
+            quint32 inProgress = readByte();
+            readByte();
+
+            visitor.onTask(taskId, taskUid, state, inProgress);
+
+            // The rest of the task block holds 4-byte objectives
+            if (taskBlock.len < 6)
+                throw QException();
+            quint32 n = (taskBlock.len - 6) / 4;
+
+            if (wantsObjectives) {
+                objectives.resize(n);
+                decryptSpan(objectives.data(), n);
+                visitor.onObjectives(objectives.constData(), n);
+            } else {
+                skipBytes(qint64(n) * sizeof(quint32));
+            }
+
+            readBlockEnd(&taskBlock);
+        }
+
+        readBlockEnd(&questBlock);
+        visitor.onQuestEnd();
     }
+
+    // Ensure we've reached the end of the block without extra data
+    readBlockEnd(&b);
 }
 
-quint32 QuestsFile::nextInt()
+void QuestsFile::skipBytes(qint64 len)
 {
-    quint32 ret;
+    // Skipped data still feeds the key schedule
+    const uchar* raw = take(len);
+    updateKey(raw, unsigned(len));
+}
 
-    // Read the next 4 bytes from the file
-    if (stream->readRawData(reinterpret_cast<char*>(&ret), sizeof(ret)) != sizeof(ret))
-        throw QException(); // Throw an exception if reading fails
+void QuestsFile::readKey()
+{
+    // Read the initial key value from the file (4 bytes)
+    quint32 k = qFromLittleEndian<quint32>(take(sizeof(quint32)));
 
-    // Decrypt the value using the current key
-    ret ^= key;
+    // XOR the key with a constant value to get the actual key
+    key = k ^ GddCipher::keyMask;
 
-    return ret;
+    // Initialize the key table used for decrypting subsequent data
+    GddCipher::buildTable(key, table);
 }
 
-void QuestsFile::updateKey(void* ptr, unsigned len)
+quint32 QuestsFile::nextInt()
 {
-    quint8* p = reinterpret_cast<quint8*>(ptr);
+    // Read the next 4 bytes from the file and decrypt them using the current key
+    return qFromLittleEndian<quint32>(take(sizeof(quint32))) ^ key;
+}
+
+void QuestsFile::updateKey(const void* ptr, unsigned len)
+{
+    const quint8* p = reinterpret_cast<const quint8*>(ptr);
 
     // Update the decryption key based on the data that was just read
     // This ensures that the key changes with each read operation
@@ -265,38 +596,46 @@ void QuestsFile::updateKey(void* ptr, unsigned len)
 
 quint32 QuestsFile::readInt()
 {
-    quint32 val;
-
     // Read the next 4 bytes from the file
-    if (stream->readRawData(reinterpret_cast<char*>(&val), sizeof(val)) != sizeof(val))
-        throw QException(); // Throw an exception if reading fails
+    const uchar* raw = take(sizeof(quint32));
 
     // Decrypt the value using the current key
-    quint32 ret = val ^ key;
+    quint32 ret = qFromLittleEndian<quint32>(raw) ^ key;
 
     // Update the key with the raw value before decryption
-    updateKey(&val, sizeof(val));
+    updateKey(raw, sizeof(quint32));
 
     return ret;
 }
 
 quint8 QuestsFile::readByte()
 {
-    quint8 val;
-
     // Read the next byte from the file
-    if (stream->readRawData(reinterpret_cast<char*>(&val), sizeof(val)) != sizeof(val))
-        throw QException(); // Throw an exception if reading fails
+    const uchar* raw = take(sizeof(quint8));
 
     // Decrypt the value using the current key
-    quint8 ret = val ^ key;
+    quint8 ret = *raw ^ key;
 
     // Update the key with the raw value before decryption
-    updateKey(&val, sizeof(val));
+    updateKey(raw, sizeof(quint8));
 
     return ret;
 }
 
+void QuestsFile::decryptSpan(quint32* out, quint32 count)
+{
+    // Consume the whole run at once and let the bulk kernel advance the key
+    const uchar* raw = take(qint64(count) * sizeof(quint32));
+    key = GddCipher::decryptWords(table, key, raw, out, count);
+}
+
+void QuestsFile::decryptBytes(quint8* out, quint32 count)
+{
+    // Consume the whole run at once and advance the key byte by byte
+    const uchar* raw = take(count);
+    key = GddCipher::decryptBytes(table, key, raw, out, count);
+}
+
 quint32 QuestsFile::readBlockStart(Block* b)
 {
     // Read the block type identifier
@@ -305,8 +644,16 @@ quint32 QuestsFile::readBlockStart(Block* b)
     // Read the length of the block
     b->len = nextInt();
 
-    // Calculate the position where the block ends in the file
-    b->end = file->pos() + b->len;
+    // The block must fit inside the enclosing block (or the file)
+    if (b->len > remaining()) {
+        qDebug() << "Block length exceeds the enclosing data. Length:" << b->len << ", Available:" << remaining();
+        throw QException();
+    }
+
+    // Calculate the position where the block ends in the file and restrict reads to it
+    b->end = pos + b->len;
+    b->parentLimit = limit;
+    limit = b->end;
 
     return ret;
 }
@@ -314,7 +661,7 @@ quint32 QuestsFile::readBlockStart(Block* b)
 void QuestsFile::readBlockEnd(Block* b)
 {
     // Get the current position in the file
-    qint64 current_pos = file->pos();
+    qint64 current_pos = pos;
 
     // Verify that we've reached the expected end position of the block
     if (current_pos != b->end)
@@ -323,6 +670,9 @@ void QuestsFile::readBlockEnd(Block* b)
         throw QException();
     }
 
+    // Give the enclosing block's data back to the cursor
+    limit = b->parentLimit;
+
     // Read the block checksum (should be 0)
     quint32 checksum = nextInt();
 
@@ -332,3 +682,24 @@ void QuestsFile::readBlockEnd(Block* b)
         throw QException();
     }
 }
+
+void QuestsFile::checkCount(quint32 count, quint32 minSize) const
+{
+    // Compare without multiplying so huge counts can't overflow
+    if (count > remaining() / minSize) {
+        qDebug() << "Element count exceeds the enclosing data. Count:" << count << ", Available bytes:" << remaining();
+        throw QException();
+    }
+}
+
+const uchar* QuestsFile::take(qint64 len)
+{
+    // Refuse to read past the end of the innermost open block
+    if (len > limit - pos)
+        throw QException();
+
+    const uchar* ptr = data + pos;
+    pos += len;
+
+    return ptr;
+}
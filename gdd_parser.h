@@ -2,20 +2,60 @@
 #define GDD_PARSER_H
 
 #include <QFile>
-#include <QDataStream>
 #include <QString>
 #include <QVector>
+#include <QVarLengthArray>
 #include <QException>
+#include <functional>
+#include <memory_resource>
+#include <vector>
 
 class QuestsFile;
 
+/**
+ * @brief Describes how elements of type T are decoded from a QuestsFile.
+ *
+ * Composite types use the default, which reads every element through its own read method.
+ * Fixed-width plain types specialize this trait with @c isBulkDecodable set and a @c readRun
+ * function that decrypts a whole run of elements in one pass.
+ *
+ * @tparam T The element type.
+ */
+template <typename T>
+struct GddElementTraits
+{
+    /// Whether a run of elements can be decoded with a single bulk call.
+    static constexpr bool isBulkDecodable = false;
+    /// Smallest number of bytes one element occupies in the file; used to validate counts.
+    static constexpr quint32 minEncodedSize = 4;
+};
+
+/// 4-byte integers are decrypted by the vectorized word kernel.
+template <>
+struct GddElementTraits<quint32>
+{
+    static constexpr bool isBulkDecodable = true;
+    static constexpr quint32 minEncodedSize = 4;
+    static void readRun(QuestsFile* gdd, quint32* out, quint32 count);
+};
+
+/// Single bytes are decrypted as one byte run.
+template <>
+struct GddElementTraits<quint8>
+{
+    static constexpr bool isBulkDecodable = true;
+    static constexpr quint32 minEncodedSize = 1;
+    static void readRun(QuestsFile* gdd, quint8* out, quint32 count);
+};
+
 /**
  * @brief Template class extending QVector to read elements from a QuestsFile.
  *
  * @tparam T The type of elements stored in the vector.
  *
  * The Vector class provides a read method to populate itself by reading from a QuestsFile.
- * It reads the number of elements and then reads each element individually.
+ * It reads the number of elements and then the elements themselves, either as one bulk run
+ * (see GddElementTraits) or one element at a time.
  */
 template <typename T>
 class Vector : public QVector<T>
@@ -27,6 +67,14 @@ public:
      * @param gdd Pointer to the QuestsFile from which to read data.
      */
     void read(QuestsFile* gdd);
+
+    /**
+     * @brief Reads @p n elements whose count is not stored in the file.
+     *
+     * @param gdd Pointer to the QuestsFile from which to read data.
+     * @param n Number of elements to read.
+     */
+    void readElements(QuestsFile* gdd, quint32 n);
 };
 
 /**
@@ -40,7 +88,8 @@ public:
     /**
      * @brief Reads the string data from the provided QuestsFile.
      *
-     * This function reads the length of the string and then reads each character individually.
+     * This function reads the length of the string, decrypts all characters in one pass into a
+     * scratch buffer and converts them to a QString with a single Latin-1 conversion.
      *
      * @param gdd Pointer to the QuestsFile from which to read data.
      */
@@ -66,6 +115,15 @@ public:
     void read(QuestsFile* gdd);
 };
 
+/// UIDs are 16 plain bytes and are decrypted as one byte run.
+template <>
+struct GddElementTraits<UID>
+{
+    static constexpr bool isBulkDecodable = true;
+    static constexpr quint32 minEncodedSize = 16;
+    static void readRun(QuestsFile* gdd, UID* out, quint32 count);
+};
+
 /**
  * @brief Class representing a list of tokens in the quests file.
  *
@@ -116,6 +174,14 @@ public:
     void read(QuestsFile* gdd);
 };
 
+/// A task is at least its identifiers, block header, state, flags and block checksum.
+template <>
+struct GddElementTraits<Task>
+{
+    static constexpr bool isBulkDecodable = false;
+    static constexpr quint32 minEncodedSize = 4 + 16 + 8 + 6 + 4;
+};
+
 /**
  * @brief Class representing a quest.
  *
@@ -141,6 +207,14 @@ public:
     void read(QuestsFile* gdd);
 };
 
+/// A quest is at least its identifiers, block header, task count and block checksum.
+template <>
+struct GddElementTraits<Quest>
+{
+    static constexpr bool isBulkDecodable = false;
+    static constexpr quint32 minEncodedSize = 4 + 16 + 8 + 4 + 4;
+};
+
 /**
  * @brief Class representing a list of quests.
  *
@@ -162,35 +236,216 @@ public:
     void read(QuestsFile* gdd);
 };
 
+/**
+ * @brief Flat structure-of-arrays representation of the quest list.
+ *
+ * Instead of a vector of quests holding vectors of tasks holding vectors of objectives, every
+ * field lives in its own contiguous array. Tasks of quest @c q are the range
+ * [questTaskOffsets[q], questTaskOffsets[q + 1]) and objectives of task @c t are the range
+ * [taskObjectiveOffsets[t], taskObjectiveOffsets[t + 1]) of the shared @ref objectives pool.
+ * Tokens, when requested, are stored the same way in @ref tokenChars.
+ *
+ * All arrays allocate from the memory resource passed to the constructor, so a parse can be
+ * served entirely from a ParseArena (see parse_context.h).
+ */
+class FlatQuestList
+{
+public:
+    /// Identifier of each quest.
+    std::pmr::vector<quint32> questIds;
+    /// Unique identifier of each quest.
+    std::pmr::vector<UID> questUids;
+    /// Index of the first task of each quest, followed by the total task count.
+    std::pmr::vector<quint32> questTaskOffsets;
+    /// Identifier of each task.
+    std::pmr::vector<quint32> taskIds;
+    /// Unique identifier of each task.
+    std::pmr::vector<UID> taskUids;
+    /// State of each task (e.g., completed, failed).
+    std::pmr::vector<quint32> taskStates;
+    /// In-progress flag of each task.
+    std::pmr::vector<quint8> taskInProgress;
+    /// Index of the first objective of each task, followed by the total objective count.
+    std::pmr::vector<quint32> taskObjectiveOffsets;
+    /// Objectives of all tasks, stored back to back.
+    std::pmr::vector<quint32> objectives;
+    /// Characters of all tokens, stored back to back.
+    std::pmr::vector<char> tokenChars;
+    /// Index of the first character of each token, followed by the total character count.
+    std::pmr::vector<quint32> tokenOffsets;
+
+    /**
+     * @brief Constructs an empty list allocating from @p resource.
+     *
+     * @param resource The memory resource used by every array of the list.
+     */
+    explicit FlatQuestList(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief Removes all quests and tokens while keeping the allocated capacity for reuse.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of quests.
+     */
+    quint32 questCount() const { return quint32(questIds.size()); }
+
+    /**
+     * @brief Returns the total number of tasks over all quests.
+     */
+    quint32 taskCount() const { return quint32(taskIds.size()); }
+
+    /**
+     * @brief Returns the number of tokens (zero unless tokens were requested).
+     */
+    quint32 tokenCount() const { return tokenOffsets.empty() ? 0 : quint32(tokenOffsets.size() - 1); }
+
+    /**
+     * @brief Returns a view of a token; it stays valid as long as the list is not modified.
+     *
+     * @param index Index of the token.
+     */
+    QLatin1String token(quint32 index) const;
+
+    /**
+     * @brief Checks whether every task of a quest is in the given state.
+     *
+     * Quests without tasks satisfy this check.
+     *
+     * @param quest Index of the quest.
+     * @param state The task state to look for.
+     * @return True if all tasks of the quest have @p state.
+     */
+    bool allTasksInState(quint32 quest, quint32 state) const;
+
+    /**
+     * @brief Checks whether any task of a quest is in the given state.
+     *
+     * @param quest Index of the quest.
+     * @param state The task state to look for.
+     * @return True if at least one task of the quest has @p state.
+     */
+    bool anyTaskInState(quint32 quest, quint32 state) const;
+};
+
+/**
+ * @brief Visitor interface for streaming through a quests file without building a tree.
+ *
+ * QuestsFile::visit calls these hooks in file order while it walks the token and quest blocks.
+ * Tokens and objectives can be skipped entirely; the decoder still advances the key over the
+ * skipped bytes so the rest of the file decrypts correctly. All views passed to the hooks are
+ * only valid for the duration of the call.
+ */
+class QuestsVisitor
+{
+public:
+    virtual ~QuestsVisitor() = default;
+
+    /**
+     * @brief Tells the decoder whether @ref onToken should be called.
+     *
+     * @return False to skip decoding of the token list.
+     */
+    virtual bool wantsTokens() const { return true; }
+
+    /**
+     * @brief Tells the decoder whether @ref onObjectives should be called.
+     *
+     * @return False to skip decoding of task objectives.
+     */
+    virtual bool wantsObjectives() const { return true; }
+
+    /**
+     * @brief Called for every entry of the token list.
+     *
+     * @param token The decrypted token.
+     */
+    virtual void onToken(QLatin1String /*token*/) {}
+
+    /**
+     * @brief Called once before the first quest with the number of quests in the file.
+     *
+     * @param count Number of quests that follow.
+     */
+    virtual void onQuestCount(quint32 /*count*/) {}
+
+    /**
+     * @brief Called at the start of every quest, before its tasks.
+     *
+     * @param id1 Identifier of the quest.
+     * @param id2 Unique identifier of the quest.
+     * @param taskCount Number of tasks that follow.
+     */
+    virtual void onQuest(quint32 /*id1*/, const UID& /*id2*/, quint32 /*taskCount*/) {}
+
+    /**
+     * @brief Called for every task of the current quest.
+     *
+     * @param id1 Identifier of the task.
+     * @param id2 Unique identifier of the task.
+     * @param state State of the task (e.g., completed, failed).
+     * @param inProgress 1 if the task is in progress, 0 otherwise.
+     */
+    virtual void onTask(quint32 /*id1*/, const UID& /*id2*/, quint32 /*state*/, quint32 /*inProgress*/) {}
+
+    /**
+     * @brief Called with the objectives of the task reported by the last @ref onTask.
+     *
+     * @param objectives Pointer to the decrypted objectives.
+     * @param count Number of objectives.
+     */
+    virtual void onObjectives(const quint32* /*objectives*/, quint32 /*count*/) {}
+
+    /**
+     * @brief Called after the last task of the current quest.
+     */
+    virtual void onQuestEnd() {}
+};
+
 /**
  * @brief Struct representing a block in the quests file.
  *
- * Contains the length of the block and the end position within the file.
+ * Contains the length of the block and the end offset within the file contents.
  */
 struct Block
 {
     /// Length of the block in bytes.
     quint32 len;
-    /// End position of the block in the file.
+    /// End offset of the block within the file contents.
     qint64 end;
+    /// Read limit of the enclosing block, restored when this block ends.
+    qint64 parentLimit;
 };
 
 /**
  * @brief Class for reading and parsing the quests file.
  *
  * Handles decryption, reading of headers, tokens, quests, and provides methods to read primitive types.
+ * The whole file is mapped (or read) into memory once and decoded through a bounded cursor,
+ * so every primitive read is a plain pointer access and position checks are integer compares.
  */
 class QuestsFile
 {
+public:
+    /// Largest quests file accepted; real saves are a few hundred kilobytes.
+    static constexpr qint64 maxFileSize = 64 * 1024 * 1024;
+
 private:
-    /// Pointer to the QFile being read.
-    QFile* file;
-    /// QDataStream associated with the file.
-    QDataStream* stream;
+    /// Start of the file contents being decoded (memory-mapped or buffered).
+    const uchar* data = nullptr;
+    /// Total number of bytes available at @ref data.
+    qint64 size = 0;
+    /// Current read offset into @ref data.
+    qint64 pos = 0;
+    /// End offset of the innermost open block (or of the file); reads never cross it.
+    qint64 limit = 0;
     /// Current decryption key.
     quint32 key;
     /// Decryption key table used for updating the key.
     quint32 table[256];
+    /// Number of quests in the last file streamed through a visitor.
+    quint32 visitedQuests = 0;
 
 public:
     /// Unique identifier for the quests file.
@@ -203,13 +458,102 @@ public:
     /**
      * @brief Reads and parses the quests file from the specified filename.
      *
-     * Opens the file, initializes decryption, and reads the file content into structured data.
+     * Opens the file, maps its contents into memory (falling back to a single buffered read
+     * when mapping is unavailable) and decodes it with @ref readFromMemory.
      *
      * @param filename The path to the quests file to read.
      */
     void read(const QString& filename);
 
+    /**
+     * @brief Decodes a quests file whose raw (encrypted) contents are already in memory.
+     *
+     * Initializes decryption and reads the content into structured data. The buffer is only
+     * referenced for the duration of the call.
+     *
+     * @param bytes Pointer to the raw file contents.
+     * @param length Number of bytes available at @p bytes.
+     */
+    void readFromMemory(const uchar* bytes, qint64 length);
+
+    /**
+     * @brief Streams the quests file through a visitor without building the data tree.
+     *
+     * The @ref tokens and @ref quests members are left untouched.
+     *
+     * @param filename The path to the quests file to read.
+     * @param visitor The visitor receiving tokens, quests, tasks and objectives.
+     */
+    void visit(const QString& filename, QuestsVisitor& visitor);
+
+    /**
+     * @brief Streams a quests file that is already in memory through a visitor.
+     *
+     * @param bytes Pointer to the raw file contents.
+     * @param length Number of bytes available at @p bytes.
+     * @param visitor The visitor receiving tokens, quests, tasks and objectives.
+     */
+    void visitFromMemory(const uchar* bytes, qint64 length, QuestsVisitor& visitor);
+
+    /**
+     * @brief Reads the quests file directly into the flat structure-of-arrays layout.
+     *
+     * No per-quest or per-task containers are created.
+     *
+     * @param filename The path to the quests file to read.
+     * @param list Receives the quests; it is cleared first.
+     * @param includeTokens Whether the token list should be stored as well.
+     */
+    void readFlat(const QString& filename, FlatQuestList& list, bool includeTokens = false);
+
 private:
+    /**
+     * @brief Maps the file into memory and hands its contents to @p decode.
+     *
+     * @param filename The path to the quests file to read.
+     * @param decode Callback decoding the raw contents.
+     */
+    void withFileContents(const QString& filename, const std::function<void(const uchar*, qint64)>& decode);
+
+    /**
+     * @brief Points the cursor at a buffer and reads the key, file header and file UID.
+     *
+     * @param bytes Pointer to the raw file contents.
+     * @param length Number of bytes available at @p bytes.
+     */
+    void beginDecode(const uchar* bytes, qint64 length);
+
+    /**
+     * @brief Releases the cursor.
+     *
+     * Runs from a scope guard, also while an exception unwinds, so it never throws; the
+     * callers check that the whole file was consumed before it runs.
+     */
+    void endDecode();
+
+    /**
+     * @brief Walks the token list block, reporting tokens to the visitor.
+     *
+     * @param visitor The visitor receiving the tokens.
+     */
+    void visitTokens(QuestsVisitor& visitor);
+
+    /**
+     * @brief Walks the quest list block, reporting quests, tasks and objectives to the visitor.
+     *
+     * @param visitor The visitor receiving the quest data.
+     */
+    void visitQuests(QuestsVisitor& visitor);
+
+    /**
+     * @brief Advances the key over raw bytes without decrypting them.
+     *
+     * Used for data the visitor is not interested in.
+     *
+     * @param len Number of bytes to skip.
+     */
+    void skipBytes(qint64 len);
+
     /**
      * @brief Reads the initial decryption key from the file and initializes the key table.
      *
@@ -234,7 +578,17 @@ private:
      * @param ptr Pointer to the data that was read.
      * @param len Length of the data in bytes.
      */
-    void updateKey(void* ptr, unsigned len);
+    void updateKey(const void* ptr, unsigned len);
+
+    /**
+     * @brief Consumes raw bytes from the in-memory cursor.
+     *
+     * Throws if fewer than @p len bytes remain in the innermost open block.
+     *
+     * @param len Number of bytes to consume.
+     * @return Pointer to the first consumed byte.
+     */
+    const uchar* take(qint64 len);
 
 public:
     /**
@@ -255,20 +609,59 @@ public:
      */
     quint8 readByte();
 
+    /**
+     * @brief Reads and decrypts a run of 4-byte integers, updating the key as it goes.
+     *
+     * Equivalent to calling @ref readInt @p count times, but decrypts the whole run in one
+     * pass with the vectorized kernel from gdd_cipher.h.
+     *
+     * @param out Receives the decrypted integers.
+     * @param count Number of integers to read.
+     */
+    void decryptSpan(quint32* out, quint32 count);
+
+    /**
+     * @brief Reads and decrypts a run of bytes, updating the key as it goes.
+     *
+     * Equivalent to calling @ref readByte @p count times.
+     *
+     * @param out Receives the decrypted bytes.
+     * @param count Number of bytes to read.
+     */
+    void decryptBytes(quint8* out, quint32 count);
+
     /**
      * @brief Begins reading a block from the file.
      *
-     * Reads the block type and length, and calculates the end position.
+     * Reads the block type and length, checks that the block fits in the enclosing one,
+     * and calculates the end position.
      *
      * @param b Pointer to a Block structure to store block information.
      * @return The block type identifier.
      */
     quint32 readBlockStart(Block* b);
 
+    /**
+     * @brief Returns the number of bytes left in the innermost open block.
+     *
+     * Counts read from the file are validated against this before anything is allocated.
+     *
+     * @return The number of readable bytes.
+     */
+    qint64 remaining() const { return limit - pos; }
+
+    /**
+     * @brief Throws unless @p count elements of at least @p minSize bytes each can still be read.
+     *
+     * @param count Element count read from the file.
+     * @param minSize Smallest encoded size of one element in bytes.
+     */
+    void checkCount(quint32 count, quint32 minSize) const;
+
     /**
      * @brief Ends reading a block and verifies its integrity.
      *
-     * Checks that the current file position matches the expected end and reads the block checksum.
+     * Checks that the current cursor position matches the expected end and reads the block checksum.
      *
      * @param b Pointer to the Block structure containing block information.
      */
@@ -0,0 +1,239 @@
+#include "gdd_cipher.h"
+#include "gdd_generator.h"
+#include "parse_context.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace
+{
+    void silentMessageHandler(QtMsgType, const QMessageLogContext&, const QString&) {}
+
+    // Records the task states the streaming decoder reports, in file order
+    class StateVisitor : public QuestsVisitor
+    {
+    public:
+        void onTask(quint32, const UID&, quint32 state, quint32) override { states.append(state); }
+        void onObjectives(const quint32*, quint32 count) override { objectives += count; }
+
+        QVector<quint32> states;
+        qint64 objectives = 0;
+    };
+
+    int failures = 0;
+
+    void check(bool ok, const QString& what)
+    {
+        if (ok)
+            return;
+
+        QTextStream(stderr) << "FAIL: " << what << Qt::endl;
+        failures++;
+    }
+
+    bool sameUid(const UID& a, const UID& b)
+    {
+        return std::memcmp(a.id, b.id, sizeof(a.id)) == 0;
+    }
+
+    // Compares the flat layout with the tree decoded by read(), field by field
+    bool sameFlat(const QuestsFile& expected, const FlatQuestList& list, bool withTokens, QString* error)
+    {
+        auto fail = [error](const QString& message) {
+            *error = message;
+            return false;
+        };
+
+        const Vector<String>& tokens = expected.tokens.tokens;
+        if (list.tokenCount() != (withTokens ? quint32(tokens.size()) : 0))
+            return fail("Token count differs");
+        for (quint32 i = 0; i < list.tokenCount(); i++) {
+            if (tokens[int(i)] != list.token(i))
+                return fail(QString("Token %1 differs").arg(i));
+        }
+
+        const Vector<Quest>& quests = expected.quests.quests;
+        if (list.questCount() != quint32(quests.size()) || list.questTaskOffsets.size() != list.questIds.size() + 1
+            || list.taskObjectiveOffsets.size() != list.taskIds.size() + 1)
+            return fail("Quest count differs");
+
+        quint32 taskCount = 0;
+        quint32 objectiveCount = 0;
+        for (int q = 0; q < quests.size(); q++) {
+            const Quest& quest = quests[q];
+            if (list.questIds[q] != quest.id1 || !sameUid(list.questUids[q], quest.id2)
+                || list.questTaskOffsets[q] != taskCount || list.questTaskOffsets[q + 1] - taskCount != quint32(quest.tasks.size()))
+                return fail(QString("Quest %1 differs").arg(q));
+
+            for (int t = 0; t < quest.tasks.size(); t++, taskCount++) {
+                const Task& task = quest.tasks[t];
+                const quint32 first = list.taskObjectiveOffsets[taskCount];
+                const quint32 end = list.taskObjectiveOffsets[taskCount + 1];
+                if (list.taskIds[taskCount] != task.id1 || !sameUid(list.taskUids[taskCount], task.id2)
+                    || list.taskStates[taskCount] != task.state || list.taskInProgress[taskCount] != quint8(task.inProgress)
+                    || first != objectiveCount || end - first != quint32(task.objectives.size())
+                    || !std::equal(task.objectives.cbegin(), task.objectives.cend(), list.objectives.cbegin() + first))
+                    return fail(QString("Task %1 of quest %2 differs").arg(t).arg(q));
+                objectiveCount = end;
+            }
+        }
+
+        if (list.taskCount() != taskCount || list.objectives.size() != objectiveCount)
+            return fail("Task or objective count differs");
+
+        return true;
+    }
+
+    bool writeFile(const QString& path, const QByteArray& bytes)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(bytes) == bytes.size();
+    }
+}
+
+int main()
+{
+    // The decoder logs every header it reads
+    qInstallMessageHandler(silentMessageHandler);
+
+    QTextStream out(stdout);
+
+    // readFlat and GddParseContext read files, so every generated save is written out as well
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        QTextStream(stderr) << "Could not create a temporary directory" << Qt::endl;
+        return 1;
+    }
+    const QString path = dir.filePath("quests.gdd");
+    const QString previousPath = dir.filePath("previous.gdd");
+
+    // One context for all files, so every parse reuses the arena of the ones before
+    GddParseContext context;
+
+    // Empty, minimal, typical and wide files
+    QVector<SyntheticSaveOptions> shapes(4);
+    shapes[0].quests = 0;
+    shapes[0].tokens = 0;
+    shapes[1].quests = 1;
+    shapes[1].tasksPerQuest = 1;
+    shapes[1].objectivesPerTask = 0;
+    shapes[1].tokens = 1;
+    shapes[3].quests = 60;
+    shapes[3].tasksPerQuest = 12;
+    shapes[3].objectivesPerTask = 33;
+    shapes[3].tokens = 300;
+
+    const quint32 seeds[] = {1, 2, 3, 42, 1000, 65537, 0x7FFFFFFF, 0xFFFFFFFF};
+    int cases = 0;
+
+    for (quint32 seed : seeds) {
+        for (SyntheticSaveOptions options : std::as_const(shapes)) {
+            options.seed = seed;
+            const QString what = QString("seed %1, %2 quests").arg(seed).arg(options.quests);
+
+            QuestsFile expected;
+            GddGenerator::generate(options, expected);
+
+            // The generated file is encrypted with the key derived from the seed, not the writer's default
+            const QByteArray bytes = GddGenerator::generateBytes(options);
+            check(bytes.size() >= 4 && (qFromLittleEndian<quint32>(bytes.constData()) ^ GddCipher::keyMask) == GddGenerator::fileKeyForSeed(seed),
+                  what + ": file key is not derived from the seed");
+
+            const uchar* data = reinterpret_cast<const uchar*>(bytes.constData());
+
+            // Comparisons describe a difference in error, which is only read after the comparison
+            QString error;
+            bool same = false;
+
+            // Decoding the file gives back the generated tree
+            QuestsFile decoded;
+            try {
+                decoded.readFromMemory(data, bytes.size());
+                same = GddGenerator::sameContents(expected, decoded, &error);
+                check(same, what + ": " + error);
+            } catch (const QException&) {
+                check(false, what + ": generated file could not be decoded");
+            }
+
+            // The streaming decoder sees the same tasks
+            StateVisitor visitor;
+            QVector<quint32> expectedStates;
+            qint64 expectedObjectives = 0;
+            for (const Quest& quest : std::as_const(expected.quests.quests)) {
+                for (const Task& task : quest.tasks) {
+                    expectedStates.append(task.state);
+                    expectedObjectives += task.objectives.size();
+                }
+            }
+            try {
+                QuestsFile file;
+                file.visitFromMemory(data, bytes.size(), visitor);
+                check(visitor.states == expectedStates && visitor.objectives == expectedObjectives, what + ": visitor differs from the tree");
+            } catch (const QException&) {
+                check(false, what + ": generated file could not be visited");
+            }
+
+            // The flat decoder gives the same quests, tasks and objectives, with tokens only if asked for
+            check(writeFile(path, bytes), what + ": generated file could not be written");
+            try {
+                QuestsFile file;
+                FlatQuestList list;
+                file.readFlat(path, list);
+                same = sameFlat(expected, list, false, &error);
+                check(same, what + ": readFlat: " + error);
+                file.readFlat(path, list, true);
+                same = sameFlat(expected, list, true, &error);
+                check(same, what + ": readFlat with tokens: " + error);
+            } catch (const QException&) {
+                check(false, what + ": generated file could not be read flat");
+            }
+
+            // So does the parse context, reusing its arena after the previous file was parsed
+            try {
+                same = sameFlat(expected, context.parse(path, true), true, &error);
+                check(same, what + ": parse: " + error);
+
+                // Once the arena has grown to the file, parsing it again needs no memory from the system
+                context.parse(path);
+                same = sameFlat(expected, context.parse(path), false, &error);
+                check(same, what + ": parse again: " + error);
+                check(context.lastParseStats().systemAllocations == 0, what + ": arena was not reused");
+
+                // Parsing another file in between leaves nothing of it behind
+                if (cases > 0) {
+                    context.parse(previousPath, true);
+                    context.reset();
+                    same = sameFlat(expected, context.parse(path, true), true, &error);
+                    check(same, what + ": parse after reset: " + error);
+                }
+            } catch (const QException&) {
+                check(false, what + ": generated file could not be parsed");
+            }
+            QFile::remove(previousPath);
+            check(QFile::rename(path, previousPath), what + ": generated file could not be kept");
+
+            // Encoding the tree again with the same key round-trips as well
+            same = GddGenerator::verifyRoundTrip(expected, GddGenerator::fileKeyForSeed(seed), &error);
+            check(same, what + ": " + error);
+
+            // A truncated file is rejected
+            bool rejected = false;
+            try {
+                QuestsFile file;
+                file.readFromMemory(data, bytes.size() - 1);
+            } catch (const QException&) {
+                rejected = true;
+            }
+            check(rejected, what + ": truncated file was accepted");
+
+            cases++;
+        }
+    }
+
+    out << cases << " cases, " << failures << " failures" << Qt::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+#include "gdd_writer.h"
+#include "gdd_cipher.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QtEndian>
+
+QuestsFileWriter::QuestsFileWriter(quint32 fileKey)
+    : fileKey(fileKey)
+    , key(0)
+{
+}
+
+QByteArray QuestsFileWriter::encode(const UID& id, const TokenList& tokens, const QuestList& quests)
+{
+    out.clear();
+
+    // Write the key, then the 'QSTX' header magic and file version 0, exactly as QuestsFile::read expects them
+    writeKey();
+    writeInt(0x58545351);
+    writeInt(0);
+
+    // Write the file UID followed by the token and quest blocks
+    writeUid(id);
+    writeTokens(tokens);
+    writeQuests(quests);
+
+    QByteArray result = out;
+    out.clear();
+
+    return result;
+}
+
+QByteArray QuestsFileWriter::encode(const QuestsFile& file)
+{
+    return encode(file.id, file.tokens, file.quests);
+}
+
+bool QuestsFileWriter::write(const QuestsFile& file, const QString& filename)
+{
+    QByteArray bytes = encode(file);
+
+    QFile f(filename);
+    // Attempt to open the file for writing, replacing any previous contents
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Could not open file for writing:" << filename;
+        return false;
+    }
+
+    return f.write(bytes) == bytes.size();
+}
+
+void QuestsFileWriter::writeKey()
+{
+    // The file stores the key masked with a constant
+    uchar raw[4];
+    qToLittleEndian<quint32>(fileKey ^ GddCipher::keyMask, raw);
+    out.append(reinterpret_cast<const char*>(raw), 4);
+
+    key = fileKey;
+    GddCipher::buildTable(key, table);
+}
+
+void QuestsFileWriter::writeInt(quint32 value)
+{
+    uchar raw[4];
+    qToLittleEndian<quint32>(value ^ key, raw);
+    out.append(reinterpret_cast<const char*>(raw), 4);
+
+    // The key is advanced with the encrypted bytes, as the reader does
+    updateKey(raw, 4);
+}
+
+void QuestsFileWriter::writeByte(quint8 value)
+{
+    uchar raw = uchar(value ^ key);
+    out.append(char(raw));
+
+    updateKey(&raw, 1);
+}
+
+void QuestsFileWriter::writeNextInt(quint32 value)
+{
+    uchar raw[4];
+    qToLittleEndian<quint32>(value ^ key, raw);
+    out.append(reinterpret_cast<const char*>(raw), 4);
+}
+
+void QuestsFileWriter::writeBytes(const quint8* bytes, quint32 count)
+{
+    for (quint32 i = 0; i < count; i++)
+        writeByte(bytes[i]);
+}
+
+void QuestsFileWriter::writeUid(const UID& uid)
+{
+    writeBytes(uid.id, 16);
+}
+
+void QuestsFileWriter::writeString(const QString& str)
+{
+    QByteArray latin1 = str.toLatin1();
+
+    writeInt(quint32(latin1.size()));
+    writeBytes(reinterpret_cast<const quint8*>(latin1.constData()), quint32(latin1.size()));
+}
+
+QuestsFileWriter::BlockMark QuestsFileWriter::beginBlock(quint32 type)
+{
+    writeInt(type);
+
+    // The length is only known once the block is complete; it is encrypted with the key in
+    // effect now and does not advance the key, so it can be patched in later
+    BlockMark mark{out.size(), key};
+    out.append(4, '\0');
+
+    return mark;
+}
+
+void QuestsFileWriter::endBlock(const BlockMark& mark)
+{
+    // The block length counts the bytes between the length field and the checksum
+    quint32 len = quint32(out.size() - mark.lengthPos - 4);
+    qToLittleEndian<quint32>(len ^ mark.lengthKey, reinterpret_cast<uchar*>(out.data() + mark.lengthPos));
+
+    // Block checksums are always zero
+    writeNextInt(0);
+}
+
+void QuestsFileWriter::updateKey(const uchar* ptr, unsigned len)
+{
+    for (unsigned i = 0; i < len; i++)
+        key ^= table[ptr[i]];
+}
+
+void QuestsFileWriter::writeTokens(const TokenList& tokens)
+{
+    // Token list: block type 10, version 2, counted strings
+    BlockMark mark = beginBlock(10);
+    writeInt(2);
+
+    writeInt(quint32(tokens.tokens.size()));
+    for (const String& token : tokens.tokens)
+        writeString(token);
+
+    endBlock(mark);
+}
+
+void QuestsFileWriter::writeQuests(const QuestList& quests)
+{
+    // Quest list: block type 11, version 4, counted quests
+    BlockMark mark = beginBlock(11);
+    writeInt(4);
+
+    writeInt(quint32(quests.quests.size()));
+    for (const Quest& quest : quests.quests)
+        writeQuest(quest);
+
+    endBlock(mark);
+}
+
+void QuestsFileWriter::writeQuest(const Quest& quest)
+{
+    // Identifiers precede the quest block
+    writeInt(quest.id1);
+    writeUid(quest.id2);
+
+    BlockMark mark = beginBlock(0);
+
+    writeInt(quint32(quest.tasks.size()));
+    for (const Task& task : quest.tasks)
+        writeTask(task);
+
+    endBlock(mark);
+}
+
+void QuestsFileWriter::writeTask(const Task& task)
+{
+    // Identifiers precede the task block
+    writeInt(task.id1);
+    writeUid(task.id2);
+
+    BlockMark mark = beginBlock(0);
+
+    // State, in-progress flag and padding byte, followed by the objectives up to the block end
+    writeInt(task.state);
+    writeByte(quint8(task.inProgress));
+    writeByte(0);
+
+    for (quint32 objective : task.objectives)
+        writeInt(objective);
+
+    endBlock(mark);
+}
@@ -0,0 +1,98 @@
+#ifndef GDD_WRITER_H
+#define GDD_WRITER_H
+
+#include "gdd_parser.h"
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * @brief Class for writing quests files in the format read by QuestsFile.
+ *
+ * Mirrors QuestsFile::read step by step: the same key scheme (masked key followed by a key
+ * table, every 4-byte and 1-byte value XORed with the running key which is then advanced with
+ * the raw bytes), the same block headers and zero block checksums. Files produced by this class
+ * decode to exactly the structures they were written from.
+ */
+class QuestsFileWriter
+{
+public:
+    /**
+     * @brief Constructs a writer that encrypts with the given file key.
+     *
+     * @param fileKey The actual (unmasked) key used to encrypt the file.
+     */
+    explicit QuestsFileWriter(quint32 fileKey = 0x2A6F1C35);
+
+    /**
+     * @brief Encodes quests file data into the encrypted on-disk representation.
+     *
+     * @param id Unique identifier of the quests file.
+     * @param tokens List of tokens used in the quests.
+     * @param quests List of quests.
+     * @return The raw file contents.
+     */
+    QByteArray encode(const UID& id, const TokenList& tokens, const QuestList& quests);
+
+    /**
+     * @brief Encodes the data held by a QuestsFile.
+     *
+     * @param file The quests file whose id, tokens and quests are written.
+     * @return The raw file contents.
+     */
+    QByteArray encode(const QuestsFile& file);
+
+    /**
+     * @brief Encodes the data held by a QuestsFile and writes it to disk.
+     *
+     * @param file The quests file whose id, tokens and quests are written.
+     * @param filename The path of the file to create or overwrite.
+     * @return True if the file was written successfully; otherwise false.
+     */
+    bool write(const QuestsFile& file, const QString& filename);
+
+private:
+    /**
+     * @brief Position and key of a block length field that is filled in when the block ends.
+     */
+    struct BlockMark
+    {
+        /// Offset of the length field in the output.
+        qsizetype lengthPos;
+        /// Key in effect when the length field was written.
+        quint32 lengthKey;
+    };
+
+    /// Writes the masked file key and initializes the key table.
+    void writeKey();
+    /// Encrypts and writes a 4-byte integer, then updates the key.
+    void writeInt(quint32 value);
+    /// Encrypts and writes a single byte, then updates the key.
+    void writeByte(quint8 value);
+    /// Encrypts and writes a 4-byte integer without updating the key.
+    void writeNextInt(quint32 value);
+    /// Encrypts and writes a run of bytes, updating the key after each one.
+    void writeBytes(const quint8* bytes, quint32 count);
+    /// Writes a 16-byte UID.
+    void writeUid(const UID& uid);
+    /// Writes a string as its length followed by its Latin-1 characters.
+    void writeString(const QString& str);
+    /// Writes the block type and reserves the block length field.
+    BlockMark beginBlock(quint32 type);
+    /// Fills in the block length and writes the zero checksum.
+    void endBlock(const BlockMark& mark);
+    /// Updates the key with raw bytes that were just written.
+    void updateKey(const uchar* ptr, unsigned len);
+
+    void writeTokens(const TokenList& tokens);
+    void writeQuests(const QuestList& quests);
+    void writeQuest(const Quest& quest);
+    void writeTask(const Task& task);
+
+    QByteArray out;            ///< Output buffer.
+    quint32 fileKey;           ///< Key the file is encrypted with.
+    quint32 key;               ///< Current encryption key.
+    quint32 table[256];        ///< Key table used for updating the key.
+};
+
+#endif // GDD_WRITER_H
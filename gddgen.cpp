@@ -0,0 +1,107 @@
+#include "gdd_generator.h"
+#include "gdd_writer.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+namespace
+{
+    // Collects the quest hashes of a quests.json database so generated saves hit real quests
+    QVector<quint32> readCatalogIds(const QString& path)
+    {
+        QVector<quint32> ids;
+
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return ids;
+
+        const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+        for (auto it = root.begin(); it != root.end(); ++it) {
+            bool ok = false;
+            quint32 hash = it.key().toUInt(&ok, 0);
+            if (ok)
+                ids.append(hash);
+        }
+
+        return ids;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gdqt_gddgen");
+
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates deterministic synthetic Grim Dawn quests.gdd files.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("output", "The quests.gdd file to write, or the save root with --characters.");
+
+    QCommandLineOption seedOption("seed", "Seed of the pseudo-random generator.", "n", "1");
+    QCommandLineOption questsOption("quests", "Number of quests per file.", "n", "200");
+    QCommandLineOption tasksOption("tasks", "Maximum number of tasks per quest.", "n", "4");
+    QCommandLineOption objectivesOption("objectives", "Maximum number of objectives per task.", "n", "2");
+    QCommandLineOption tokensOption("tokens", "Number of tokens per file.", "n", "50");
+    QCommandLineOption catalogOption("catalog", "Draw quest ids from this quests.json database.", "path");
+    QCommandLineOption charactersOption("characters", "Write a save tree with this many characters x 3 difficulties.", "n");
+    QCommandLineOption verifyOption("verify", "Check that the generated data survives a write/read round trip.");
+    parser.addOptions({seedOption, questsOption, tasksOption, objectivesOption, tokensOption,
+                       catalogOption, charactersOption, verifyOption});
+
+    parser.process(app);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 1) {
+        parser.showHelp(1);
+    }
+
+    SyntheticSaveOptions options;
+    options.seed = parser.value(seedOption).toUInt();
+    options.quests = parser.value(questsOption).toUInt();
+    options.tasksPerQuest = parser.value(tasksOption).toUInt();
+    options.objectivesPerTask = parser.value(objectivesOption).toUInt();
+    options.tokens = parser.value(tokensOption).toUInt();
+
+    if (parser.isSet(catalogOption)) {
+        options.questIds = readCatalogIds(parser.value(catalogOption));
+        if (options.questIds.isEmpty()) {
+            err << "No quest ids found in " << parser.value(catalogOption) << Qt::endl;
+            return 1;
+        }
+    }
+
+    // Round-trip the data before writing anything, so a broken writer or reader is caught first
+    if (parser.isSet(verifyOption)) {
+        QuestsFile file;
+        GddGenerator::generate(options, file);
+
+        QString error;
+        if (!GddGenerator::verifyRoundTrip(file, GddGenerator::fileKeyForSeed(options.seed), &error)) {
+            err << "Round trip failed: " << error << Qt::endl;
+            return 2;
+        }
+        err << "Round trip verified." << Qt::endl;
+    }
+
+    bool ok;
+    if (parser.isSet(charactersOption)) {
+        ok = GddGenerator::generateSaveTree(positional.first(), parser.value(charactersOption).toUInt(), options);
+    } else {
+        QFile out(positional.first());
+        QByteArray bytes = GddGenerator::generateBytes(options);
+        ok = out.open(QIODevice::WriteOnly | QIODevice::Truncate) && out.write(bytes) == bytes.size();
+    }
+
+    if (!ok) {
+        err << "Failed to write " << positional.first() << Qt::endl;
+        return 1;
+    }
+
+    return 0;
+}
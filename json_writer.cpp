@@ -0,0 +1,109 @@
+#include "json_writer.h"
+
+#include <QIODevice>
+
+namespace
+{
+    // Output is handed to the device in blocks of about this size
+    constexpr int flushThreshold = 64 * 1024;
+
+    char hexDigit(int value)
+    {
+        return char(value < 10 ? '0' + value : 'a' + value - 10);
+    }
+}
+
+JsonStreamWriter::JsonStreamWriter(QIODevice* device) : device(device)
+{
+    buffer.reserve(flushThreshold + 1024);
+}
+
+void JsonStreamWriter::beginObject()
+{
+    buffer.append("{\n");
+    hasMembers.append(false);
+}
+
+void JsonStreamWriter::endObject()
+{
+    if (hasMembers.isEmpty())
+        return;
+
+    if (hasMembers.takeLast())
+        buffer.append('\n');
+    buffer.append(QByteArray(4 * hasMembers.size(), ' '));
+    buffer.append('}');
+
+    // The root object ends the document
+    if (hasMembers.isEmpty()) {
+        buffer.append('\n');
+        flush(true);
+    } else {
+        flush();
+    }
+}
+
+void JsonStreamWriter::writeKey(const QString& key)
+{
+    if (hasMembers.isEmpty())
+        return;
+
+    if (hasMembers.last())
+        buffer.append(",\n");
+    hasMembers.last() = true;
+
+    buffer.append(QByteArray(4 * hasMembers.size(), ' '));
+    appendString(key);
+    buffer.append(": ");
+}
+
+void JsonStreamWriter::writeString(const QString& value)
+{
+    appendString(value);
+}
+
+void JsonStreamWriter::appendString(const QString& value)
+{
+    buffer.append('"');
+
+    // Same escapes as QJsonDocument: quote, backslash and control characters; other text as UTF-8
+    const QByteArray utf8 = value.toUtf8();
+    for (char c : utf8) {
+        const uchar u = uchar(c);
+        if (u >= 0x20 && u != '"' && u != '\\') {
+            buffer.append(c);
+            continue;
+        }
+
+        buffer.append('\\');
+        switch (u) {
+        case '"': buffer.append('"'); break;
+        case '\\': buffer.append('\\'); break;
+        case '\b': buffer.append('b'); break;
+        case '\f': buffer.append('f'); break;
+        case '\n': buffer.append('n'); break;
+        case '\r': buffer.append('r'); break;
+        case '\t': buffer.append('t'); break;
+        default:
+            buffer.append("u00");
+            buffer.append(hexDigit(u >> 4));
+            buffer.append(hexDigit(u & 0xF));
+            break;
+        }
+    }
+
+    buffer.append('"');
+}
+
+void JsonStreamWriter::flush(bool force)
+{
+    if (buffer.isEmpty() || (!force && buffer.size() < flushThreshold))
+        return;
+
+    if (device->write(buffer) != buffer.size())
+        failed = true;
+
+    written += buffer.size();
+    hash.addData(buffer);
+    buffer.resize(0); // Keeps the capacity for the next block
+}
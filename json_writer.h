@@ -0,0 +1,61 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+/**
+ * @brief Writes a JSON document to a device incrementally, without building it in memory.
+ *
+ * The output is byte-for-byte what QJsonDocument::toJson(QJsonDocument::Indented) produces for
+ * the same data: four spaces of indentation per level, "key": value pairs, the same string
+ * escapes and a newline after the root object. Keys must be written in sorted order, as
+ * QJsonObject sorts them.
+ */
+class JsonStreamWriter
+{
+public:
+    /**
+     * @brief Constructs a writer that appends to @p device, which must be open for writing.
+     */
+    explicit JsonStreamWriter(QIODevice* device);
+
+    /// Starts an object, either as the root or as the value of the last written key.
+    void beginObject();
+    /// Ends the innermost object.
+    void endObject();
+    /// Writes the key of the next member of the current object.
+    void writeKey(const QString& key);
+    /// Writes a string value for the last written key.
+    void writeString(const QString& value);
+
+    /**
+     * @brief Returns false if any write to the device failed.
+     */
+    bool ok() const { return !failed; }
+
+    /// Number of bytes written so far.
+    qint64 bytesWritten() const { return written; }
+
+    /// MD5 digest (16 raw bytes) of the bytes written so far.
+    QByteArray md5() const { return hash.result(); }
+
+private:
+    /// Writes the pending buffer to the device once it is large enough, or always if @p force.
+    void flush(bool force = false);
+    /// Appends a quoted, escaped string to the buffer.
+    void appendString(const QString& value);
+
+    QIODevice* device;          ///< Destination of the output.
+    QByteArray buffer;          ///< Output not written to the device yet.
+    QVector<bool> hasMembers;   ///< Per open object: whether a member was written already.
+    qint64 written = 0;         ///< Bytes handed to the device.
+    QCryptographicHash hash{QCryptographicHash::Md5}; ///< Digest of the bytes handed to the device.
+    bool failed = false;        ///< Set when the device rejected a write.
+};
+
+#endif // JSON_WRITER_H
@@ -1,4 +1,5 @@
 #include "jsonparser.h"
+#include "trace.h"
 #include <QFile>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -6,9 +7,12 @@
 #include <QJsonArray>
 #include <QDebug>
 #include <QException>
+#include <QSet>
 
 void JsonParser::read(const QString& filename)
 {
+    TraceZone zone("JsonParser::read");
+
     QFile file(filename);
 
     // Check if the file exists and open it in read-only mode.
@@ -21,6 +25,7 @@ void JsonParser::read(const QString& filename)
     // Read all data from the file and close it after reading.
     QByteArray data = file.readAll();
     file.close();
+    zone.setBytes(data.size());
 
     // Attempt to parse the JSON data; log and throw an error if parsing fails.
     QJsonParseError parseError;
@@ -41,6 +46,7 @@ void JsonParser::read(const QString& filename)
 
     // Process each key-value pair in the root JSON object.
     QJsonObject rootObj = doc.object();
+    QSet<QString> foundLocales{"enUS"};
 
     for (auto it = rootObj.begin(); it != rootObj.end(); ++it)
     {
@@ -53,7 +59,20 @@ void JsonParser::read(const QString& filename)
         info.Chapter = questObj.value("Chapter").toString();
         info.QuestName = questObj.value("QuestName").toString();
 
+        // Names in other languages, if the database was generated with them
+        const QJsonObject localizedObj = questObj.value("Localized").toObject();
+        for (auto locale = localizedObj.begin(); locale != localizedObj.end(); ++locale) {
+            const QJsonObject namesObj = locale.value().toObject();
+            info.Localized.insert(locale.key(), {namesObj.value("Chapter").toString(), namesObj.value("QuestName").toString()});
+            foundLocales.insert(locale.key());
+        }
+
         // Insert the quest data into the map using the lowercase key.
         questData.insert(key, info);
     }
+
+    locales = QStringList(foundLocales.begin(), foundLocales.end());
+    locales.sort();
+
+    zone.setItems(questData.size());
 }
@@ -3,7 +3,8 @@
 
 #include <QMap>
 #include <QString>
-#include "types.h"
+#include <QStringList>
+#include "quest_types.h"
 
 /**
  * @class JsonParser
@@ -25,6 +26,11 @@ public:
      */
     QMap<QString, QuestInfo> questData;
 
+    /**
+     * @brief Locale tags of all languages in the quest data, sorted, always including "enUS".
+     */
+    QStringList locales;
+
     /**
      * @brief Reads and parses the quest data from a JSON file.
      *
@@ -0,0 +1,155 @@
+#include "lz4_block.h"
+
+#include <QtEndian>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // Format limits of the LZ4 block format
+    constexpr int minMatch = 4;
+    constexpr int lastLiterals = 5;     // The last 5 bytes are always literals
+    constexpr int matchStartLimit = 12; // The last match starts at least 12 bytes before the end
+    constexpr int maxOffset = 65535;
+
+    constexpr int hashBits = 12;
+
+    // Reads a length continued in extra bytes (each 255 adds to it, the first smaller one ends it)
+    bool readLength(const uchar*& ip, const uchar* end, size_t& length)
+    {
+        uchar byte;
+        do {
+            if (ip >= end)
+                return false;
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+
+        return true;
+    }
+
+    void writeLength(QByteArray& out, size_t length)
+    {
+        while (length >= 255) {
+            out.append(char(255));
+            length -= 255;
+        }
+        out.append(char(length));
+    }
+
+    quint32 read32(const uchar* ptr)
+    {
+        quint32 value;
+        memcpy(&value, ptr, sizeof(value));
+        return value;
+    }
+}
+
+bool Lz4::decompress(const char* src, int srcSize, char* dst, int dstSize)
+{
+    const uchar* ip = reinterpret_cast<const uchar*>(src);
+    const uchar* const ipEnd = ip + srcSize;
+    uchar* const opStart = reinterpret_cast<uchar*>(dst);
+    uchar* op = opStart;
+    uchar* const opEnd = op + dstSize;
+
+    while (ip < ipEnd) {
+        const uchar token = *ip++;
+
+        // Literals
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(ip, ipEnd, literalLength))
+            return false;
+        if (literalLength > size_t(ipEnd - ip) || literalLength > size_t(opEnd - op))
+            return false;
+
+        memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        // The last sequence has no match
+        if (ip == ipEnd)
+            break;
+
+        // Match
+        if (ipEnd - ip < 2)
+            return false;
+        const size_t offset = qFromLittleEndian<quint16>(ip);
+        ip += 2;
+        if (offset == 0 || offset > size_t(op - opStart))
+            return false;
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(ip, ipEnd, matchLength))
+            return false;
+        matchLength += minMatch;
+        if (matchLength > size_t(opEnd - op))
+            return false;
+
+        // Overlapping matches repeat the last bytes, so they are copied byte by byte
+        const uchar* match = op - offset;
+        if (offset >= matchLength) {
+            memcpy(op, match, matchLength);
+            op += matchLength;
+        } else {
+            for (size_t i = 0; i < matchLength; i++)
+                *op++ = *match++;
+        }
+    }
+
+    return op == opEnd;
+}
+
+QByteArray Lz4::compress(const QByteArray& data)
+{
+    const uchar* src = reinterpret_cast<const uchar*>(data.constData());
+    const int size = int(data.size());
+
+    QByteArray out;
+    out.reserve(size + size / 255 + 16);
+
+    auto writeSequence = [&](int literalStart, int literalLength, int offset, int matchLength) {
+        const int matchCode = matchLength >= minMatch ? matchLength - minMatch : 0;
+        out.append(char((qMin(literalLength, 15) << 4) | qMin(matchCode, 15)));
+        if (literalLength >= 15)
+            writeLength(out, literalLength - 15);
+
+        out.append(reinterpret_cast<const char*>(src) + literalStart, literalLength);
+
+        if (matchLength >= minMatch) {
+            out.append(char(offset & 0xFF));
+            out.append(char(offset >> 8));
+            if (matchCode >= 15)
+                writeLength(out, matchCode - 15);
+        }
+    };
+
+    std::vector<int> table(1 << hashBits, -1);
+    int anchor = 0;
+    int pos = 0;
+
+    // Greedy matching: take the first candidate of the hash table and extend it as far as allowed
+    while (pos <= size - matchStartLimit) {
+        const quint32 sequence = read32(src + pos);
+        const quint32 hash = (sequence * 2654435761u) >> (32 - hashBits);
+        const int candidate = table[hash];
+        table[hash] = pos;
+
+        if (candidate < 0 || pos - candidate > maxOffset || read32(src + candidate) != sequence) {
+            pos++;
+            continue;
+        }
+
+        int length = minMatch;
+        while (pos + length < size - lastLiterals && src[candidate + length] == src[pos + length])
+            length++;
+
+        writeSequence(anchor, pos - anchor, pos - candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+
+    writeSequence(anchor, size - anchor, 0, 0);
+    return out;
+}
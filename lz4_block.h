@@ -0,0 +1,40 @@
+#ifndef LZ4_BLOCK_H
+#define LZ4_BLOCK_H
+
+#include <QByteArray>
+
+/**
+ * @brief Minimal codec for the LZ4 block format used by Grim Dawn archives.
+ *
+ * Only raw blocks are supported (no frame header or checksums); the decompressed size must be
+ * known in advance, as it is stored in the archive.
+ */
+namespace Lz4
+{
+    /**
+     * @brief Decompresses one LZ4 block.
+     *
+     * Every read and write is bounds-checked, so corrupt input fails instead of overrunning.
+     *
+     * @param src Compressed block.
+     * @param srcSize Size of the compressed block in bytes.
+     * @param dst Buffer that receives the decompressed data.
+     * @param dstSize Expected decompressed size; the block must decode to exactly this many bytes.
+     * @return True if the block was valid and filled @p dst completely; otherwise false.
+     */
+    bool decompress(const char* src, int srcSize, char* dst, int dstSize);
+
+    /**
+     * @brief Compresses data into one LZ4 block.
+     *
+     * A simple greedy compressor, meant for producing test archives rather than for speed or
+     * ratio. The output follows the format rules (end literals, match limits), so any LZ4
+     * decoder accepts it.
+     *
+     * @param data Data to compress.
+     * @return The compressed block.
+     */
+    QByteArray compress(const QByteArray& data);
+}
+
+#endif // LZ4_BLOCK_H
@@ -1,11 +1,41 @@
 #include "questtrackerwindow.h"
+#include "trace.h"
+#include "stall_watchdog.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QFontDatabase>
 
+#include <optional>
+
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+
+    // Optional Chrome trace of the startup and every later refresh, written when the application exits
+    QCommandLineOption traceOption("trace", "Record a Chrome trace-event file, viewable in Perfetto.", "file");
+    parser.addOption(traceOption);
+
+    // Optional watchdog logging every event loop stall longer than the threshold, with a histogram on exit
+    QCommandLineOption stallOption("stall-threshold", "Report GUI event loop stalls longer than this many milliseconds (e.g. 16 or 100).", "ms");
+    parser.addOption(stallOption);
+    parser.process(a);
+
+    if (parser.isSet(traceOption)) {
+        Trace::start();
+    }
+
+    std::optional<StallWatchdog> watchdog;
+    if (parser.isSet(stallOption)) {
+        watchdog.emplace(parser.value(stallOption).toInt());
+        watchdog->start();
+    }
+
+    std::optional<TraceZone> startupZone(std::in_place, "startup");
+
     QuestTrackerWindow w;
 
     // The font path points to a Grim Dawn-themed font, inspired by www.grimtools.com where a similar font was used.
@@ -31,6 +61,25 @@ int main(int argc, char *argv[])
 
     // Display the main window
     w.show();
+    startupZone.reset();
+
+    int result = a.exec();
+
+    // The log widget is gone from the screen by now, so report on the console
+    qInstallMessageHandler(nullptr);
+
+    if (watchdog) {
+        watchdog->stop();
+        qInfo().noquote() << watchdog->summary();
+    }
+
+    if (parser.isSet(traceOption)) {
+        Trace::stop();
+
+        if (!Trace::writeChromeTrace(parser.value(traceOption))) {
+            qWarning() << "Failed to write trace file:" << parser.value(traceOption);
+        }
+    }
 
-    return a.exec();
+    return result;
 }
@@ -0,0 +1,133 @@
+#include "parse_context.h"
+
+#include <QScopeGuard>
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+ParseArena::ParseArena(std::size_t initialSize)
+    : m_initialSize(std::max<std::size_t>(initialSize, 4096))
+{
+}
+
+ParseArena::~ParseArena()
+{
+    for (const Chunk& chunk : m_chunks)
+        ::operator delete(chunk.data);
+}
+
+void ParseArena::reset()
+{
+    m_current = 0;
+    m_offset = 0;
+    m_allocationCount = 0;
+    m_bytesAllocated = 0;
+    m_systemAllocationCount = 0;
+
+    // Merge the chunks of a parse that outgrew the arena, so the next parse fits in one chunk
+    if (m_chunks.size() > 1) {
+        std::size_t total = 0;
+        for (const Chunk& chunk : m_chunks) {
+            total += chunk.size;
+            ::operator delete(chunk.data);
+        }
+
+        m_chunks.clear();
+        m_chunks.push_back({static_cast<char*>(::operator new(total)), total});
+
+        // The merged chunk is a system allocation of the parse that follows
+        m_systemAllocationCount++;
+    }
+}
+
+quint64 ParseArena::capacity() const
+{
+    quint64 total = 0;
+    for (const Chunk& chunk : m_chunks)
+        total += chunk.size;
+
+    return total;
+}
+
+void* ParseArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    m_allocationCount++;
+    m_bytesAllocated += bytes;
+
+    for (;;) {
+        if (m_current < m_chunks.size()) {
+            const Chunk& chunk = m_chunks[m_current];
+
+            // Bump the offset inside the current chunk so the returned address has the requested
+            // alignment; chunks themselves are only aligned for the default operator new
+            const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(chunk.data);
+            std::size_t aligned = std::size_t(((base + m_offset + alignment - 1) & ~std::uintptr_t(alignment - 1)) - base);
+            if (aligned + bytes <= chunk.size) {
+                m_offset = aligned + bytes;
+                return chunk.data + aligned;
+            }
+
+            // Move on to the next retained chunk, if there is one
+            if (m_current + 1 < m_chunks.size()) {
+                m_current++;
+                m_offset = 0;
+                continue;
+            }
+        }
+
+        // Out of space: request a new chunk and retry
+        addChunk(bytes + alignment);
+    }
+}
+
+void ParseArena::do_deallocate(void*, std::size_t, std::size_t)
+{
+    // Memory is only reclaimed by reset()
+}
+
+bool ParseArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+void ParseArena::addChunk(std::size_t minSize)
+{
+    // Grow geometrically so the number of chunks stays logarithmic in the parse size
+    std::size_t size = m_chunks.empty() ? m_initialSize : m_chunks.back().size * 2;
+    size = std::max(size, minSize);
+
+    m_chunks.push_back({static_cast<char*>(::operator new(size)), size});
+    m_current = m_chunks.size() - 1;
+    m_offset = 0;
+    m_systemAllocationCount++;
+}
+
+GddParseContext::GddParseContext(std::size_t initialArenaSize)
+    : m_arena(initialArenaSize)
+{
+    m_list.emplace(&m_arena);
+}
+
+const FlatQuestList& GddParseContext::parse(const QString& filename, bool includeTokens)
+{
+    reset();
+
+    // Record the arena counters even if the parse fails half-way
+    auto recordStats = qScopeGuard([this] {
+        m_lastStats.allocations = m_arena.allocationCount();
+        m_lastStats.bytes = m_arena.bytesAllocated();
+        m_lastStats.systemAllocations = m_arena.systemAllocationCount();
+    });
+
+    m_file.readFlat(filename, *m_list, includeTokens);
+
+    return *m_list;
+}
+
+void GddParseContext::reset()
+{
+    // Destroy the containers before rewinding the arena that backs them
+    m_list.reset();
+    m_arena.reset();
+    m_list.emplace(&m_arena);
+}
@@ -0,0 +1,142 @@
+#ifndef PARSE_CONTEXT_H
+#define PARSE_CONTEXT_H
+
+#include "gdd_parser.h"
+
+#include <QString>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Monotonic bump allocator used to serve all allocations of one parse.
+ *
+ * Memory is handed out from large chunks and never freed individually. @ref reset rewinds the
+ * arena for the next parse while keeping its memory, so once the arena has grown to the size of
+ * the largest file, parsing further files does not reach the system allocator at all.
+ */
+class ParseArena : public std::pmr::memory_resource
+{
+public:
+    /**
+     * @brief Constructs an arena whose first chunk holds @p initialSize bytes.
+     *
+     * @param initialSize Size of the first chunk in bytes; it is allocated lazily.
+     */
+    explicit ParseArena(std::size_t initialSize = 64 * 1024);
+
+    /**
+     * @brief Releases all chunks back to the system allocator.
+     */
+    ~ParseArena() override;
+
+    ParseArena(const ParseArena&) = delete;
+    ParseArena& operator=(const ParseArena&) = delete;
+
+    /**
+     * @brief Resets the counters and rewinds the arena.
+     *
+     * Everything allocated from the arena becomes invalid. If the last parse needed more than one
+     * chunk, they are merged into a single chunk of the combined size, which counts as a system
+     * allocation of the next parse; in steady state the reset is a constant-time pointer rewind.
+     */
+    void reset();
+
+    /// Number of allocations served since the last reset.
+    quint64 allocationCount() const { return m_allocationCount; }
+    /// Number of bytes handed out since the last reset.
+    quint64 bytesAllocated() const { return m_bytesAllocated; }
+    /// Number of chunks requested from the system allocator since the last reset.
+    quint64 systemAllocationCount() const { return m_systemAllocationCount; }
+    /// Total size of the chunks currently owned by the arena.
+    quint64 capacity() const;
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+    struct Chunk
+    {
+        char* data;
+        std::size_t size;
+    };
+
+    /// Allocates a new chunk able to hold at least @p minSize bytes.
+    void addChunk(std::size_t minSize);
+
+    std::vector<Chunk> m_chunks;              ///< Chunks owned by the arena.
+    std::size_t m_initialSize;                ///< Size of the first chunk.
+    std::size_t m_current = 0;                ///< Index of the chunk being filled.
+    std::size_t m_offset = 0;                 ///< Fill level of the current chunk.
+    quint64 m_allocationCount = 0;            ///< Allocations since the last reset.
+    quint64 m_bytesAllocated = 0;             ///< Bytes handed out since the last reset.
+    quint64 m_systemAllocationCount = 0;      ///< Chunk allocations since the last reset.
+};
+
+/**
+ * @brief Reusable context for parsing many quests.gdd files back to back.
+ *
+ * Owns a @ref ParseArena and a @ref FlatQuestList allocating from it. Every call to @ref parse
+ * resets the arena in O(1) and decodes the next file into the flat layout, so batch scanning
+ * (three difficulties per character, many characters) does not rebuild containers from scratch.
+ */
+class GddParseContext
+{
+public:
+    /**
+     * @brief Per-parse allocation statistics taken from the arena.
+     */
+    struct ParseStats
+    {
+        /// Allocations served by the arena during the parse.
+        quint64 allocations = 0;
+        /// Bytes handed out by the arena during the parse.
+        quint64 bytes = 0;
+        /// Chunks the arena had to request from the system allocator during the parse.
+        quint64 systemAllocations = 0;
+    };
+
+    /**
+     * @brief Constructs a context with an arena of @p initialArenaSize bytes.
+     *
+     * @param initialArenaSize Size of the first arena chunk in bytes.
+     */
+    explicit GddParseContext(std::size_t initialArenaSize = 256 * 1024);
+
+    /**
+     * @brief Resets the arena and parses a quests file into the flat layout.
+     *
+     * The returned list stays valid until the next call to @ref parse or @ref reset.
+     * Throws QException if the file cannot be parsed.
+     *
+     * @param filename The path to the quests file to read.
+     * @param includeTokens Whether the token list should be stored as well.
+     * @return The parsed quests.
+     */
+    const FlatQuestList& parse(const QString& filename, bool includeTokens = false);
+
+    /**
+     * @brief Returns the quests of the last parse.
+     */
+    const FlatQuestList& list() const { return *m_list; }
+
+    /**
+     * @brief Returns the allocation statistics of the last parse.
+     */
+    ParseStats lastParseStats() const { return m_lastStats; }
+
+    /**
+     * @brief Drops the parsed data and rewinds the arena.
+     */
+    void reset();
+
+private:
+    ParseArena m_arena;                       ///< Arena serving every container of a parse.
+    std::optional<FlatQuestList> m_list;      ///< Flat quest data allocated from the arena.
+    QuestsFile m_file;                        ///< Decoder reused across parses.
+    ParseStats m_lastStats;                   ///< Statistics of the last parse.
+};
+
+#endif // PARSE_CONTEXT_H
@@ -0,0 +1,175 @@
+#include "perf_counters.h"
+#include "trace.h"
+
+#include <QHash>
+#include <QMutex>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+namespace
+{
+    struct ZoneHistory
+    {
+        std::array<qint64, PerfCounters::historySize> durations{};
+        std::array<qint64, PerfCounters::historySize> bytes{};
+        quint64 count = 0;
+        qint64 lastItems = -1;
+    };
+
+    struct Gauge
+    {
+        qint64 value = 0;
+        qint64 peak = 0;
+    };
+
+    QMutex countersMutex;
+    // Keyed by contents, as the same literal may have a different address in every translation unit
+    QHash<QLatin1String, ZoneHistory> zoneHistories;
+    QHash<QLatin1String, PerfCounters::RatioStats> lookupCounters;
+    QHash<QLatin1String, Gauge> gaugeValues;
+    std::atomic<quint64> changeCount{0};
+
+    template <typename T>
+    void sortByName(QVector<T>& list)
+    {
+        std::sort(list.begin(), list.end(), [](const T& a, const T& b) { return a.name < b.name; });
+    }
+}
+
+void PerfCounters::setEnabled(bool enabled)
+{
+    Trace::setCounting(enabled);
+}
+
+void PerfCounters::addZone(const char* name, qint64 durationNs, qint64 bytes, qint64 items)
+{
+    QMutexLocker locker(&countersMutex);
+
+    // Samples go into a ring buffer, so only the most recent ones are summarized
+    ZoneHistory& history = zoneHistories[QLatin1String(name)];
+    int slot = int(history.count % historySize);
+    history.durations[slot] = durationNs;
+    history.bytes[slot] = bytes;
+    history.lastItems = items;
+    history.count++;
+
+    changeCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerfCounters::addLookups(const char* name, quint64 hits, quint64 misses)
+{
+    QMutexLocker locker(&countersMutex);
+
+    RatioStats& counter = lookupCounters[QLatin1String(name)];
+    counter.hits += hits;
+    counter.misses += misses;
+
+    changeCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerfCounters::setGauge(const char* name, qint64 value)
+{
+    QMutexLocker locker(&countersMutex);
+
+    Gauge& gauge = gaugeValues[QLatin1String(name)];
+    gauge.value = value;
+    gauge.peak = qMax(gauge.peak, value);
+
+    changeCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+quint64 PerfCounters::generation()
+{
+    return changeCount.load(std::memory_order_relaxed);
+}
+
+QVector<PerfCounters::ZoneStats> PerfCounters::zones()
+{
+    QMutexLocker locker(&countersMutex);
+
+    QVector<ZoneStats> result;
+    result.reserve(zoneHistories.size());
+
+    for (auto it = zoneHistories.cbegin(); it != zoneHistories.cend(); ++it) {
+        const ZoneHistory& history = it.value();
+        int samples = int(qMin<quint64>(history.count, historySize));
+        int last = int((history.count - 1) % historySize);
+
+        ZoneStats stats;
+        stats.name = QString(it.key());
+        stats.count = history.count;
+        stats.lastNs = history.durations[last];
+        stats.lastBytes = history.bytes[last];
+        stats.lastItems = history.lastItems;
+
+        QVector<qint64> durations(history.durations.begin(), history.durations.begin() + samples);
+        std::sort(durations.begin(), durations.end());
+
+        qint64 totalNs = 0;
+        qint64 totalBytes = 0;
+        bool hasBytes = false;
+        for (int i = 0; i < samples; i++) {
+            totalNs += history.durations[i];
+            if (history.bytes[i] >= 0) {
+                totalBytes += history.bytes[i];
+                hasBytes = true;
+            }
+        }
+
+        stats.meanNs = totalNs / samples;
+        stats.p95Ns = durations[qMin(samples - 1, (samples * 95 + 99) / 100 - 1)];
+        stats.maxNs = durations.last();
+        if (hasBytes && totalNs > 0)
+            stats.megabytesPerSecond = double(totalBytes) * 1000.0 / double(totalNs);
+
+        result.append(stats);
+    }
+
+    sortByName(result);
+    return result;
+}
+
+QVector<PerfCounters::RatioStats> PerfCounters::lookups()
+{
+    QMutexLocker locker(&countersMutex);
+
+    QVector<RatioStats> result;
+    for (auto it = lookupCounters.cbegin(); it != lookupCounters.cend(); ++it) {
+        RatioStats stats = it.value();
+        stats.name = QString(it.key());
+        result.append(stats);
+    }
+
+    sortByName(result);
+    return result;
+}
+
+QVector<PerfCounters::GaugeStats> PerfCounters::gauges()
+{
+    QMutexLocker locker(&countersMutex);
+
+    QVector<GaugeStats> result;
+    for (auto it = gaugeValues.cbegin(); it != gaugeValues.cend(); ++it) {
+        GaugeStats stats;
+        stats.name = QString(it.key());
+        stats.value = it.value().value;
+        stats.peak = it.value().peak;
+        result.append(stats);
+    }
+
+    sortByName(result);
+    return result;
+}
+
+void PerfCounters::reset()
+{
+    QMutexLocker locker(&countersMutex);
+
+    zoneHistories.clear();
+    lookupCounters.clear();
+    gaugeValues.clear();
+
+    changeCount.fetch_add(1, std::memory_order_relaxed);
+}
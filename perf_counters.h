@@ -0,0 +1,108 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @brief In-process performance counters shown on the Diagnostics tab.
+ *
+ * Keeps the last @ref historySize timings of every trace zone (fed by TraceZone while counting
+ * is enabled), hit/miss totals of lookups and caches, and gauges such as queue depths. All
+ * functions are thread-safe.
+ */
+namespace PerfCounters
+{
+    /// Number of recent samples kept per zone.
+    constexpr int historySize = 64;
+
+    /**
+     * @brief Summary of the recent samples of one zone.
+     */
+    struct ZoneStats
+    {
+        QString name;
+        /// Number of samples since startup or the last reset.
+        quint64 count = 0;
+        /// Duration of the latest sample in nanoseconds.
+        qint64 lastNs = 0;
+        /// Mean, 95th percentile and maximum duration over the recent samples.
+        qint64 meanNs = 0;
+        qint64 p95Ns = 0;
+        qint64 maxNs = 0;
+        /// Bytes and items of the latest sample, or -1 if the zone does not report them.
+        qint64 lastBytes = -1;
+        qint64 lastItems = -1;
+        /// Throughput over the recent samples in MB/s, or -1 if the zone does not report bytes.
+        double megabytesPerSecond = -1;
+    };
+
+    /**
+     * @brief Hit and miss totals of one lookup or cache.
+     */
+    struct RatioStats
+    {
+        QString name;
+        quint64 hits = 0;
+        quint64 misses = 0;
+    };
+
+    /**
+     * @brief Latest value of one gauge.
+     */
+    struct GaugeStats
+    {
+        QString name;
+        qint64 value = 0;
+        /// Highest value since startup or the last reset.
+        qint64 peak = 0;
+    };
+
+    /**
+     * @brief Starts or stops feeding completed trace zones into the counters.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief Adds one completed zone; normally called by TraceZone.
+     *
+     * @param name Zone name; must point to a string literal or other static storage.
+     */
+    void addZone(const char* name, qint64 durationNs, qint64 bytes, qint64 items);
+
+    /**
+     * @brief Adds hit and miss counts to a lookup or cache.
+     *
+     * @param name Counter name; must point to a string literal or other static storage.
+     */
+    void addLookups(const char* name, quint64 hits, quint64 misses);
+
+    /**
+     * @brief Sets the current value of a gauge.
+     *
+     * @param name Gauge name; must point to a string literal or other static storage.
+     */
+    void setGauge(const char* name, qint64 value);
+
+    /**
+     * @brief Returns a number that changes whenever any counter changes.
+     *
+     * Lets a periodic display skip its update when nothing happened.
+     */
+    quint64 generation();
+
+    /// Returns the statistics of every zone seen so far, sorted by name.
+    QVector<ZoneStats> zones();
+    /// Returns every lookup counter, sorted by name.
+    QVector<RatioStats> lookups();
+    /// Returns every gauge, sorted by name.
+    QVector<GaugeStats> gauges();
+
+    /**
+     * @brief Clears all counters.
+     */
+    void reset();
+}
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,112 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <QVector>
+#include <QtGlobal>
+
+#include <algorithm>
+
+/**
+ * @brief Minimal perfect hash over 32-bit keys ("hash and displace").
+ *
+ * The keys are split into buckets by one hash; every bucket has a seed, chosen when the table
+ * is built, that sends its keys to distinct slots among exactly as many slots as keys. A lookup
+ * is two hashes and one array read, and the key stored in the slot tells whether it is a member.
+ *
+ * Shared by gdqt_embedgen, which builds the table into the generated header, QuestDatabase,
+ * which looks the quests up in it, and gdqt_perfect_hash_test.
+ */
+namespace PerfectHash
+{
+    /// Mixes a key with a seed (the MurmurHash3 finalizer).
+    constexpr quint32 mix(quint32 key, quint32 seed)
+    {
+        quint32 h = key ^ (seed * 0x9E3779B9u);
+        h ^= h >> 16;
+        h *= 0x85EBCA6Bu;
+        h ^= h >> 13;
+        h *= 0xC2B2AE35u;
+        h ^= h >> 16;
+        return h;
+    }
+
+    /// Bucket of a key; bucket seeds start at 1, so this hash differs from every slot hash.
+    constexpr quint32 bucketOf(quint32 key, quint32 bucketCount)
+    {
+        return mix(key, 0) % bucketCount;
+    }
+
+    /// Slot of a key, given the seed of its bucket.
+    constexpr quint32 slotOf(quint32 key, quint32 seed, quint32 slotCount)
+    {
+        return mix(key, seed) % slotCount;
+    }
+
+    // Keys per bucket on average; smaller buckets find their seeds faster
+    constexpr int keysPerBucket = 4;
+    // Gives up on a bucket after this many seeds and retries with more buckets
+    constexpr quint32 maxSeed = 1u << 20;
+
+    /**
+     * @brief Finds a seed per bucket that sends every key to its own slot.
+     *
+     * @param keys The distinct keys.
+     * @param bucketCount Number of buckets.
+     * @param seeds Receives the seed of every bucket (0 for empty buckets).
+     * @param slotKeys Receives the key stored in every slot.
+     * @return False if some bucket has no seed below maxSeed.
+     */
+    inline bool build(const QVector<quint32>& keys, quint32 bucketCount, QVector<quint32>& seeds, QVector<quint32>& slotKeys)
+    {
+        const quint32 slotCount = quint32(keys.size());
+
+        // Sized by resize(), as "buckets(int(bucketCount))" would declare a function
+        QVector<QVector<quint32>> buckets;
+        buckets.resize(int(bucketCount));
+        for (quint32 key : keys)
+            buckets[int(bucketOf(key, bucketCount))].append(key);
+
+        // Place the largest buckets first, while most slots are still free
+        QVector<int> order(buckets.size());
+        for (int i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return buckets[a].size() > buckets[b].size(); });
+
+        seeds.fill(0, int(bucketCount));
+        slotKeys.fill(0, int(slotCount));
+        QVector<char> used(int(slotCount), 0);
+        QVector<quint32> bucketSlots;
+
+        for (int bucket : std::as_const(order)) {
+            const QVector<quint32>& bucketKeys = buckets[bucket];
+            if (bucketKeys.isEmpty())
+                break;
+
+            quint32 seed = 1;
+            for (; seed < maxSeed; seed++) {
+                bucketSlots.clear();
+                for (quint32 key : bucketKeys) {
+                    const quint32 slot = slotOf(key, seed, slotCount);
+                    if (used[int(slot)] || bucketSlots.contains(slot))
+                        break;
+                    bucketSlots.append(slot);
+                }
+                if (bucketSlots.size() == bucketKeys.size())
+                    break;
+            }
+
+            if (seed == maxSeed)
+                return false;
+
+            seeds[bucket] = seed;
+            for (int i = 0; i < bucketSlots.size(); i++) {
+                used[int(bucketSlots[i])] = 1;
+                slotKeys[int(bucketSlots[i])] = bucketKeys[i];
+            }
+        }
+
+        return true;
+    }
+}
+
+#endif // PERFECT_HASH_H
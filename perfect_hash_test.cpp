@@ -0,0 +1,196 @@
+#include "jsonparser.h"
+#include "perfect_hash.h"
+#include "quest_catalog.h"
+#include "quest_database.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QException>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+
+namespace
+{
+    void silentMessageHandler(QtMsgType, const QMessageLogContext&, const QString&) {}
+
+    int failures = 0;
+
+    void check(bool ok, const QString& what)
+    {
+        if (ok)
+            return;
+
+        QTextStream(stderr) << "FAIL: " << what << Qt::endl;
+        failures++;
+    }
+
+    QString hashKey(quint32 hash)
+    {
+        return QString("0x%1").arg(hash, 8, 16, QChar('0'));
+    }
+
+    // Builds the table for distinct random keys and checks that it is a minimal perfect hash of exactly those keys
+    void checkPerfectHash(int keyCount, quint32 bucketCount, QRandomGenerator& rng)
+    {
+        const QString what = QString("%1 keys in %2 buckets").arg(keyCount).arg(bucketCount);
+
+        QSet<quint32> keySet;
+        while (keySet.size() < keyCount)
+            keySet.insert(rng.generate());
+        const QVector<quint32> keys(keySet.begin(), keySet.end());
+
+        QVector<quint32> seeds;
+        QVector<quint32> slotKeys;
+        if (!PerfectHash::build(keys, bucketCount, seeds, slotKeys)) {
+            check(false, what + ": no seeds found");
+            return;
+        }
+        check(seeds.size() == int(bucketCount), what + ": wrong number of seeds");
+
+        // Every key has its own slot, and there are no other slots
+        QVector<quint32> sortedKeys = keys;
+        QVector<quint32> sortedSlots = slotKeys;
+        std::sort(sortedKeys.begin(), sortedKeys.end());
+        std::sort(sortedSlots.begin(), sortedSlots.end());
+        check(sortedSlots == sortedKeys, what + ": slots do not hold every key once");
+
+        for (quint32 key : keys) {
+            const quint32 seed = seeds[int(PerfectHash::bucketOf(key, bucketCount))];
+            const quint32 slot = PerfectHash::slotOf(key, seed, quint32(slotKeys.size()));
+            check(slotKeys[int(slot)] == key, what + ": " + hashKey(key) + " is not in its slot");
+        }
+
+        // Any other key lands on a slot holding a different key
+        if (keys.isEmpty())
+            return;
+        for (int misses = 0; misses < 1000;) {
+            const quint32 key = rng.generate();
+            if (keySet.contains(key))
+                continue;
+            const quint32 seed = seeds[int(PerfectHash::bucketOf(key, bucketCount))];
+            check(slotKeys[int(PerfectHash::slotOf(key, seed, quint32(slotKeys.size())))] != key, what + ": " + hashKey(key) + " found");
+            misses++;
+        }
+    }
+
+    // Every quest is found with its flags and names in every language, and absent hashes are not
+    void compare(const QuestDatabase& database, const QMap<quint32, QuestInfo>& quests, const QStringList& locales,
+                 const QString& source, QRandomGenerator& rng)
+    {
+        check(database.count() == quests.size(), source + ": wrong quest count");
+        check(database.locales() == locales, source + ": wrong languages");
+
+        for (auto it = quests.cbegin(); it != quests.cend(); ++it) {
+            const QString what = source + ", quest " + hashKey(it.key());
+            const int index = database.find(it.key());
+            check(index >= 0 && database.hashAt(index) == it.key(), what + ": not found");
+            if (index < 0)
+                continue;
+
+            check(database.flags(index) == QuestCatalog::flagsOf(it.value()), what + ": flags differ");
+            for (const QString& locale : locales) {
+                const LocalizedNames expected = QuestCatalog::namesOf(it.value(), locale);
+                const LocalizedNames& names = database.names(index, database.localeIndex(locale));
+                check(names.Chapter == expected.Chapter && names.QuestName == expected.QuestName, what + ": names in " + locale + " differ");
+            }
+        }
+
+        int misses = 0;
+        while (misses < 10000) {
+            const quint32 hash = rng.generate();
+            if (quests.contains(hash))
+                continue;
+            check(database.find(hash) == -1, source + ": " + hashKey(hash) + " found but not in the database");
+            misses++;
+        }
+    }
+
+    bool writeFile(const QString& path, const QByteArray& bytes)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(bytes) == bytes.size();
+    }
+
+    // The built-in database, the quests.json it was generated from and its catalog give the same lookups
+    void checkBuiltIn(const QString& jsonPath, QRandomGenerator& rng)
+    {
+        QFile jsonFile(jsonPath);
+        if (!jsonFile.open(QIODevice::ReadOnly)) {
+            check(false, "cannot read " + jsonPath);
+            return;
+        }
+        const QByteArray json = jsonFile.readAll();
+
+        // The expected quests, keyed like QuestDatabase keys them
+        JsonParser parser;
+        parser.read(jsonPath);
+        QMap<quint32, QuestInfo> quests;
+        for (auto it = parser.questData.cbegin(); it != parser.questData.cend(); ++it) {
+            bool ok = false;
+            const quint32 hash = it.key().toUInt(&ok, 0);
+            if (ok)
+                quests.insert(hash, it.value());
+        }
+        QStringList locales = parser.locales;
+        locales.removeAll("enUS");
+        locales.prepend("enUS");
+
+        QTemporaryDir dir;
+        check(dir.isValid(), "could not create a temporary directory");
+        QDir(dir.path()).mkdir("json");
+        QDir(dir.path()).mkdir("catalog");
+
+        compare(*QuestDatabase::load(QString()), quests, locales, "built-in", rng);
+
+        // A trailing space keeps the JSON valid but no longer the built-in one, so it is parsed
+        const QString copyPath = dir.filePath("json/quests.json");
+        check(writeFile(copyPath, json + ' '), "copy of quests.json could not be written");
+        compare(*QuestDatabase::load(copyPath), quests, locales, "JSON", rng);
+
+        // Without quests.json its catalog is used unchecked, in place of the built-in database
+        const QString catalogJsonPath = dir.filePath("catalog/quests.json");
+        check(QuestCatalog::write(QuestCatalog::pathFor(catalogJsonPath), quests, json.size(), QCryptographicHash::hash(json, QCryptographicHash::Md5)),
+              "catalog could not be written");
+        compare(*QuestDatabase::load(catalogJsonPath), quests, locales, "catalog", rng);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Loading logs the source of every database
+    qInstallMessageHandler(silentMessageHandler);
+
+    QTextStream out(stdout);
+    QRandomGenerator rng(20241017);
+
+    // Sizes around the bucket boundaries, with the bucket count gdqt_embedgen starts with, and a single bucket
+    const QVector<int> keyCounts = {0, 1, 2, 3, 4, 5, 7, 8, 9, 63, 64, 65, 1000, 4321};
+    for (int keyCount : keyCounts)
+        checkPerfectHash(keyCount, quint32(qMax(1, (keyCount + PerfectHash::keysPerBucket - 1) / PerfectHash::keysPerBucket)), rng);
+    for (int keyCount : {1, 2, 5, 9})
+        checkPerfectHash(keyCount, 1, rng);
+
+    const QStringList arguments = app.arguments();
+    if (!QuestDatabase::hasBuiltIn()) {
+        out << "No built-in quest database (GDQT_EMBED_QUESTS is off), not compared" << Qt::endl;
+    } else if (arguments.size() != 2) {
+        check(false, "usage: gdqt_perfect_hash_test <quests.json the built-in database was generated from>");
+    } else {
+        try {
+            checkBuiltIn(arguments[1], rng);
+        } catch (const QException&) {
+            check(false, "quest database could not be loaded");
+        }
+    }
+
+    out << keyCounts.size() << " key sets, " << failures << " failures" << Qt::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -1,15 +1,48 @@
 #include "qst_parser.h"
+#include "trace.h"
+#include <QByteArrayMatcher>
+#include <QtEndian>
+#include <QScopeGuard>
+
+#include <iterator>
 
 QstFile::QstFile() : questHash(0) {}
 QstFile::QstFile(const QString &filePath) : filePath(filePath), questHash(0) {}
 
 bool QstFile::parse()
 {
-    // Read the entire file into memory
-    if (!readFile()) {
+    TraceZone zone("QstFile::parse");
+
+    // Map or read the entire file; the data must not outlive the file, as it may refer to the mapping
+    QFile file(filePath);
+    auto releaseData = qScopeGuard([this] { data.clear(); });
+
+    if (!readFile(file)) {
         return false;
     }
+    zone.setBytes(data.size());
+
+    return parseData();
+}
+
+bool QstFile::parse(const QByteArray &contents)
+{
+    TraceZone zone("QstFile::parse");
+    zone.setBytes(contents.size());
+
+    if (contents.size() > maxFileSize) {
+        qWarning() << "File too large to be a quest file:" << filePath;
+        return false;
+    }
+
+    data = contents;
+    auto releaseData = qScopeGuard([this] { data.clear(); });
+
+    return parseData();
+}
 
+bool QstFile::parseData()
+{
     // Extract the quest hash from the file data
     if (!extractQuestHash()) {
         return false;
@@ -38,19 +71,40 @@ uint32_t QstFile::getQuestHash() const
     return questHash;
 }
 
-bool QstFile::readFile()
+bool QstFile::usedScanFallback() const
 {
-    QFile file(filePath);
+    return namesScanned;
+}
+
+QMap<QString, QstLocalization> QstFile::getLocalizations() const
+{
+    return localizations;
+}
 
+bool QstFile::readFile(QFile &file)
+{
     // Attempt to open the file in read-only mode
     if (!file.open(QIODevice::ReadOnly)) {
         qWarning() << "Could not open file:" << filePath;
         return false;
     }
 
-    // Read all data from the file into the 'data' member variable
+    // Refuse files that can't be a quest script before buffering them
+    if (file.size() > maxFileSize) {
+        qWarning() << "File too large to be a quest file:" << filePath;
+        return false;
+    }
+
+    // Map the file instead of copying it; the mapping stays valid until the file is closed
+    if (file.size() > 0) {
+        if (uchar *mapped = file.map(0, file.size())) {
+            data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), int(file.size()));
+            return true;
+        }
+    }
+
+    // Read all data from the file into the 'data' member variable if it can't be mapped
     data = file.readAll();
-    file.close();
 
     return true;
 }
@@ -64,13 +118,129 @@ bool QstFile::extractQuestHash()
     }
 
     // Read 4 bytes starting from the 12th byte as the quest hash
-    // This assumes the quest hash is located at offset 12
-    questHash = *reinterpret_cast<const uint32_t*>(data.constData() + 12);
+    // This assumes the quest hash is located at offset 12; the read must not assume alignment
+    questHash = qFromLittleEndian<quint32>(data.constData() + 12);
 
     return true;
 }
 
+namespace
+{
+    // Locale of the names used as quest database keys
+    const char defaultLocale[] = "enUS";
+
+    // Languages Grim Dawn ships or community translations use; other letter runs are not records
+    const char localeTags[][5] = {
+        "csCZ", "deDE", "enUS", "esES", "frFR", "huHU", "itIT", "jaJP", "koKR",
+        "plPL", "ptBR", "ruRU", "trTR", "ukUA", "viVN", "zhCN", "zhTW",
+    };
+
+    constexpr int localeTagCount = int(std::size(localeTags));
+
+    // One matcher per tag, so the scan jumps from one occurrence to the next instead of testing every byte
+    struct LocaleTagMatchers
+    {
+        LocaleTagMatchers()
+        {
+            for (int i = 0; i < localeTagCount; i++)
+                matchers[i].setPattern(QByteArray::fromRawData(localeTags[i], 4));
+        }
+
+        QByteArrayMatcher matchers[localeTagCount];
+    };
+    const LocaleTagMatchers localeTagMatchers;
+
+    // Upper bound for a chapter or quest name, to reject lengths read from unrelated bytes
+    constexpr quint32 maxNameLength = 1024;
+}
+
 bool QstFile::extractLocalizationData()
+{
+    localizations.clear();
+    namesScanned = false;
+
+    // Next occurrence of every tag at or after the position, -1 once the tag does not occur any more
+    const QByteArrayMatcher *matchers = localeTagMatchers.matchers;
+    int next[localeTagCount];
+    for (int i = 0; i < localeTagCount; i++)
+        next[i] = int(matchers[i].indexIn(data, 0));
+
+    // Collect every locale tag followed by two well-formed strings in file order, skipping past each record found
+    const char *bytes = data.constData();
+    int position = 0;
+    for (;;) {
+        int tag = -1;
+        for (int i = 0; i < localeTagCount; i++) {
+            if (next[i] >= 0 && next[i] < position)
+                next[i] = int(matchers[i].indexIn(data, position));
+            if (next[i] >= 0 && (tag < 0 || next[i] < next[tag]))
+                tag = i;
+        }
+        if (tag < 0 || next[tag] > data.size() - 8)
+            break;
+
+        position = next[tag];
+        int offset = position + 4;
+        QstLocalization names;
+
+        if (readLengthPrefixedString(offset, names.chapterName) && readLengthPrefixedString(offset, names.questName)) {
+            const QString locale = QString::fromLatin1(bytes + position, 4);
+            if (!localizations.contains(locale))
+                localizations.insert(locale, names);
+            position = offset;
+        } else {
+            position++;
+        }
+    }
+
+    auto english = localizations.constFind(defaultLocale);
+    if (english != localizations.constEnd()) {
+        chapterName = english->chapterName;
+        questName = english->questName;
+        return true;
+    }
+
+    // The scan guesses where the names start and end, so they may be cut short or contain stray characters
+    qWarning() << "No length-prefixed localization record, scanning for names in file:" << filePath;
+    if (!extractLocalizationDataByScan())
+        return false;
+
+    namesScanned = true;
+    localizations.insert(defaultLocale, {chapterName, questName});
+    return true;
+}
+
+bool QstFile::readLengthPrefixedString(int &offset, QString &value) const
+{
+    if (offset < 0 || data.size() - offset < 4)
+        return false;
+
+    quint32 length = qFromLittleEndian<quint32>(data.constData() + offset);
+    if (length == 0 || length > maxNameLength || length > quint32(data.size() - offset - 4))
+        return false;
+
+    const char *bytes = data.constData() + offset + 4;
+    int size = int(length);
+
+    // The stored length may include the terminating null byte
+    if (bytes[size - 1] == '\0')
+        size--;
+
+    if (size == 0)
+        return false;
+
+    // Text never contains control characters; bytes of multi-byte UTF-8 sequences are >= 0x80
+    for (int i = 0; i < size; i++) {
+        if (static_cast<uchar>(bytes[i]) < 0x20)
+            return false;
+    }
+
+    value = QString::fromUtf8(bytes, size).trimmed();
+    offset += 4 + int(length);
+    return !value.isEmpty();
+}
+
+bool QstFile::extractLocalizationDataByScan()
 {
     // **Lazy Reading Approach**
     // Instead of parsing the file according to its correct structure,
@@ -6,6 +6,16 @@
 #include <QString>
 #include <QRegularExpression>
 #include <QDebug>
+#include <QMap>
+
+/**
+ * @brief Chapter and quest name of a quest in one language.
+ */
+struct QstLocalization
+{
+    QString chapterName;
+    QString questName;
+};
 
 /**
  * @class QstFile
@@ -13,16 +23,18 @@
  *
  * The QstFile class provides functionality to read and parse QST files,
  * extracting information such as the quest hash, chapter name, and quest name.
- * It uses a "lazy reading" approach by searching for specific markers within
- * the binary data to locate the necessary information. Instead of parsing the
- * entire file structure, it looks for the 'enUS' marker and offsets from there
- * to find the required data. This method should be improved in the future by
- * implementing a full parser for the QST file structure, similar to how GDD files
- * are handled.
+ * The quest hash is read from the file header. The names are read from the localization
+ * records, each a locale tag such as 'enUS' or 'deDE' followed by length-prefixed strings,
+ * using the stored lengths; all languages are collected in one pass over the file.
+ * Files whose record does not have that layout fall back to the older "lazy reading"
+ * scan, which skips non-letter bytes after the 'enUS' marker.
  */
 class QstFile
 {
 public:
+    /// Largest QST file accepted; quest scripts are far smaller than this.
+    static constexpr qint64 maxFileSize = 16 * 1024 * 1024;
+
     /**
      * @brief Default constructor.
      *
@@ -48,6 +60,16 @@ public:
      */
     bool parse();
 
+    /**
+     * @brief Parses QST data that is already in memory, e.g. extracted from an archive.
+     *
+     * The file path given to the constructor is only used in messages.
+     *
+     * @param contents The raw QST file contents.
+     * @return True if parsing was successful; otherwise false.
+     */
+    bool parse(const QByteArray &contents);
+
     /**
      * @brief Gets the name of the chapter.
      *
@@ -71,6 +93,20 @@ public:
      */
     uint32_t getQuestHash() const;
 
+    /**
+     * @brief Gets the names of the quest in every language found in the file.
+     *
+     * @return The names keyed by locale tag (e.g. "deDE"), including "enUS".
+     */
+    QMap<QString, QstLocalization> getLocalizations() const;
+
+    /**
+     * @brief Tells whether the names were found by the marker scan instead of a localization record.
+     *
+     * @return True if extractLocalizationDataByScan() provided the names; otherwise false.
+     */
+    bool usedScanFallback() const;
+
 private:
     /// Path to the QST file.
     QString filePath;
@@ -81,20 +117,35 @@ private:
     /// Extracted quest name from the QST file.
     QString questName;
 
+    /// Names in every language, keyed by locale tag.
+    QMap<QString, QstLocalization> localizations;
+
+    /// Whether the names come from the marker scan.
+    bool namesScanned = false;
+
     /// Quest hash used as a unique identifier.
     uint32_t questHash;
 
-    /// Raw binary data read from the QST file.
+    /// Raw binary data of the QST file; only valid while parse() runs.
     QByteArray data;
 
     /**
-     * @brief Reads the QST file into memory.
+     * @brief Makes the QST file contents available in the 'data' member variable.
      *
-     * This function opens the file and reads all its contents into the 'data' member variable.
+     * The file is memory-mapped when possible, so 'data' refers to the mapping and is only
+     * valid while @p file stays open; otherwise its contents are read into memory.
      *
+     * @param file The QST file, not yet opened.
      * @return True if the file was read successfully; otherwise false.
      */
-    bool readFile();
+    bool readFile(QFile &file);
+
+    /**
+     * @brief Extracts the quest hash and names from the 'data' member variable.
+     *
+     * @return True if parsing was successful; otherwise false.
+     */
+    bool parseData();
 
     /**
      * @brief Extracts the quest hash from the file data.
@@ -109,6 +160,36 @@ private:
     /**
      * @brief Extracts localization data (chapter and quest names) from the file data.
      *
+     * Reads the record following every Grim Dawn locale tag (e.g. 'enUS', 'deDE', 'zhCN';
+     * other letter runs shaped like a tag are ignored): two strings, each preceded by its
+     * 32-bit little-endian length. The strings are taken as stored, so names starting with
+     * digits or punctuation are kept intact. The 'enUS' record provides the chapter and quest
+     * name; if there is none, they come from extractLocalizationDataByScan().
+     *
+     * The QST section layout is not documented, so the file is not walked by its section
+     * lengths. Instead a QByteArrayMatcher per tag jumps from one tag occurrence to the next,
+     * in file order, and the bytes in between are never looked at one by one. The regex scan
+     * stays as the fallback for files without length-prefixed records.
+     *
+     * @return True if the localization data was extracted successfully; otherwise false.
+     */
+    bool extractLocalizationData();
+
+    /**
+     * @brief Reads one length-prefixed string of the localization record.
+     *
+     * The length may or may not count a terminating null byte. Fails without moving
+     * @p offset if the length is out of bounds or the string contains control characters.
+     *
+     * @param offset Position of the length field; moved past the string on success.
+     * @param value Receives the string.
+     * @return True if a valid string was read; otherwise false.
+     */
+    bool readLengthPrefixedString(int &offset, QString &value) const;
+
+    /**
+     * @brief Extracts localization data by scanning for the 'enUS' marker.
+     *
      * **Lazy Reading Approach:**
      * Instead of parsing the file according to its correct structure, we search for a specific
      * marker ('enUS') and use offsets from there. This is considered "lazy reading" because
@@ -121,7 +202,7 @@ private:
      *
      * @return True if the localization data was extracted successfully; otherwise false.
      */
-    bool extractLocalizationData();
+    bool extractLocalizationDataByScan();
 };
 
 #endif // QST_PARSER_H
@@ -0,0 +1,304 @@
+#include "quest_catalog.h"
+#include "trace.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QtEndian>
+
+namespace
+{
+    // Size of the fixed header, and of the JSON digest at its end
+    constexpr quint32 headerSize = 48;
+    constexpr int md5Size = 16;
+
+    // Locale tags are stored as 4 bytes; the English names are always the first language
+    const QString englishLocale = QStringLiteral("enUS");
+
+    void appendUInt(QByteArray &out, quint32 value)
+    {
+        char bytes[4];
+        qToLittleEndian<quint32>(value, bytes);
+        out.append(bytes, 4);
+    }
+
+    void putUInt(QByteArray &out, int offset, quint32 value)
+    {
+        qToLittleEndian<quint32>(value, out.data() + offset);
+    }
+
+    /**
+     * @brief Collects the distinct names, each stored once with its UTF-8 length.
+     */
+    class StringPool
+    {
+    public:
+        quint32 intern(const QString &value)
+        {
+            auto known = offsets.constFind(value);
+            if (known != offsets.constEnd())
+                return known.value();
+
+            const QByteArray utf8 = value.toUtf8();
+            const quint32 offset = quint32(bytes.size());
+            appendUInt(bytes, quint32(utf8.size()));
+            bytes.append(utf8);
+            offsets.insert(value, offset);
+            return offset;
+        }
+
+        QByteArray bytes;
+
+    private:
+        QHash<QString, quint32> offsets;
+    };
+}
+
+QString QuestCatalog::pathFor(const QString& jsonPath)
+{
+    const QFileInfo info(jsonPath);
+    return info.dir().filePath(info.completeBaseName() + ".qcat");
+}
+
+bool QuestCatalog::write(const QString& path, const QMap<quint32, QuestInfo>& quests, qint64 jsonSize, const QByteArray& jsonMd5)
+{
+    TraceZone zone("QuestCatalog::write");
+
+    if (jsonMd5.size() != md5Size) {
+        qWarning() << "Not writing quest catalog without the JSON digest:" << path;
+        return false;
+    }
+
+    // English first, then every other language of any quest in tag order
+    QStringList localeTags;
+    for (const QuestInfo &info : quests) {
+        for (auto it = info.Localized.cbegin(); it != info.Localized.cend(); ++it) {
+            if (it.key() != englishLocale && it.key().size() == 4 && !localeTags.contains(it.key()))
+                localeTags.append(it.key());
+        }
+    }
+    localeTags.sort();
+    localeTags.prepend(englishLocale);
+
+    const quint32 questCount = quint32(quests.size());
+    const quint32 localeCount = quint32(localeTags.size());
+
+    QByteArray out;
+    out.reserve(int(headerSize + localeCount * 4 + questCount * (8 + localeCount * 8)));
+    out.fill('\0', int(headerSize));
+
+    for (const QString &locale : std::as_const(localeTags))
+        out.append(locale.toLatin1());
+
+    // QMap iterates in key order, so the hashes are already sorted for the binary search
+    for (auto it = quests.cbegin(); it != quests.cend(); ++it)
+        appendUInt(out, it.key());
+
+    StringPool pool;
+    for (const QuestInfo &info : quests) {
+        appendUInt(out, flagsOf(info));
+
+        for (const QString &locale : std::as_const(localeTags)) {
+            const LocalizedNames names = namesOf(info, locale);
+            appendUInt(out, pool.intern(names.Chapter));
+            appendUInt(out, pool.intern(names.QuestName));
+        }
+    }
+
+    putUInt(out, 0, magic);
+    putUInt(out, 4, version);
+    putUInt(out, 8, questCount);
+    putUInt(out, 12, localeCount);
+    putUInt(out, 16, quint32(out.size()));
+    putUInt(out, 20, quint32(pool.bytes.size()));
+    putUInt(out, 24, quint32(jsonSize));
+    putUInt(out, 28, quint32(quint64(jsonSize) >> 32));
+    out.replace(32, md5Size, jsonMd5);
+    out.append(pool.bytes);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(out) != out.size() || !file.commit()) {
+        qWarning() << "Could not write quest catalog:" << path;
+        return false;
+    }
+
+    zone.setBytes(out.size());
+    zone.setItems(quests.size());
+    return true;
+}
+
+bool QuestCatalog::open(const QString& path, const QString& jsonPath)
+{
+    TraceZone zone("QuestCatalog::open");
+
+    // Forget any previously opened catalog
+    file.close();
+    buffer.clear();
+    base = nullptr;
+    size = 0;
+    questCount = 0;
+    localeCount = 0;
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false; // No catalog, the JSON database is used
+
+    // The catalog is addressed with 32-bit offsets
+    const qint64 fileSize = file.size();
+    if (fileSize < headerSize || fileSize > 0xffffffffLL) {
+        qWarning() << "Ignoring malformed quest catalog:" << path;
+        file.close();
+        return false;
+    }
+
+    // Map the catalog, or read it into memory if it can't be mapped
+    const uchar* mapped = file.map(0, fileSize);
+    if (mapped) {
+        base = reinterpret_cast<const char*>(mapped);
+    } else {
+        buffer = file.readAll();
+        base = buffer.constData();
+    }
+    size = quint32(fileSize);
+    zone.setBytes(size);
+
+    auto reject = [this, &path](const char *reason) {
+        qWarning() << "Ignoring quest catalog" << path << "-" << reason;
+        file.close();
+        buffer.clear();
+        base = nullptr;
+        size = 0;
+        questCount = 0;
+        localeCount = 0;
+        return false;
+    };
+
+    if (qint64(buffer.size()) != fileSize && !mapped)
+        return reject("it could not be read");
+    if (readUInt(0) != magic)
+        return reject("not a quest catalog");
+    if (readUInt(4) != version)
+        return reject("written by another version");
+
+    questCount = readUInt(8);
+    localeCount = readUInt(12);
+    poolOffset = readUInt(16);
+    poolSize = readUInt(20);
+    const qint64 jsonSize = qint64(readUInt(24)) | (qint64(readUInt(28)) << 32);
+
+    // Each locale and quest takes at least 4 bytes, which bounds both counts by 2^30, so the
+    // 64-bit sums below cannot wrap and every offset derived from them fits the file
+    const quint64 available = size - headerSize;
+    if (localeCount == 0 || localeCount > available / 4 || questCount > available / 4)
+        return reject("tables do not match the file size");
+
+    // The tables follow each other without gaps, the pool ends the file
+    const quint64 recordSize = 4 + quint64(localeCount) * 8;
+    const quint64 localesEnd = headerSize + quint64(localeCount) * 4;
+    const quint64 hashesEnd = localesEnd + quint64(questCount) * 4;
+    const quint64 tablesEnd = hashesEnd + quint64(questCount) * recordSize;
+    if (tablesEnd != poolOffset || quint64(poolOffset) + poolSize != size)
+        return reject("tables do not match the file size");
+
+    hashesOffset = quint32(localesEnd);
+    recordsOffset = quint32(hashesEnd);
+
+    // A quests.json replaced after the catalog was written takes precedence; only one of the same size is read
+    if (!jsonPath.isEmpty()) {
+        QFile json(jsonPath);
+        if (json.exists()) {
+            if (json.size() != jsonSize)
+                return reject("it does not belong to the current quest database");
+
+            QCryptographicHash md5(QCryptographicHash::Md5);
+            if (!json.open(QIODevice::ReadOnly) || !md5.addData(&json))
+                return reject("the quest database could not be read");
+            if (md5.result() != QByteArray::fromRawData(base + 32, md5Size))
+                return reject("it does not belong to the current quest database");
+        }
+    }
+
+    // Every name offset must point to a string inside the pool
+    for (quint32 i = 0; i < questCount; i++) {
+        for (quint32 field = 1; field < recordSize / 4; field++) {
+            const quint32 offset = recordField(int(i), int(field));
+            if (quint64(offset) + 4 > poolSize || quint64(offset) + 4 + readUInt(poolOffset + offset) > poolSize)
+                return reject("name outside the string pool");
+        }
+    }
+
+    zone.setItems(questCount);
+    qDebug() << "Quest catalog" << path << "mapped with" << questCount << "quests in" << localeCount << "languages.";
+    return true;
+}
+
+QStringList QuestCatalog::locales() const
+{
+    QStringList tags;
+    for (quint32 i = 0; i < localeCount; i++)
+        tags.append(QString::fromLatin1(base + headerSize + i * 4, 4));
+    return tags;
+}
+
+int QuestCatalog::localeIndex(const QString& locale) const
+{
+    const int index = locales().indexOf(locale);
+    return index < 0 ? 0 : index;
+}
+
+int QuestCatalog::find(quint32 questHash) const
+{
+    int low = 0;
+    int high = int(questCount) - 1;
+    while (low <= high) {
+        const int middle = low + (high - low) / 2;
+        const quint32 hash = hashAt(middle);
+        if (hash == questHash)
+            return middle;
+        if (hash < questHash)
+            low = middle + 1;
+        else
+            high = middle - 1;
+    }
+    return -1;
+}
+
+quint32 QuestCatalog::hashAt(int index) const
+{
+    return readUInt(hashesOffset + quint32(index) * 4);
+}
+
+quint32 QuestCatalog::flags(int index) const
+{
+    return recordField(index, 0);
+}
+
+QString QuestCatalog::chapter(int index, int locale) const
+{
+    return poolString(recordField(index, 1 + locale * 2));
+}
+
+QString QuestCatalog::questName(int index, int locale) const
+{
+    return poolString(recordField(index, 2 + locale * 2));
+}
+
+quint32 QuestCatalog::readUInt(quint32 offset) const
+{
+    return qFromLittleEndian<quint32>(base + offset);
+}
+
+QString QuestCatalog::poolString(quint32 offset) const
+{
+    const quint32 start = poolOffset + offset;
+    return QString::fromUtf8(base + start + 4, int(readUInt(start)));
+}
+
+quint32 QuestCatalog::recordField(int index, int field) const
+{
+    const quint32 recordSize = 4 + localeCount * 8;
+    return readUInt(recordsOffset + quint32(index) * recordSize + quint32(field) * 4);
+}
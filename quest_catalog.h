@@ -0,0 +1,142 @@
+#ifndef QUEST_CATALOG_H
+#define QUEST_CATALOG_H
+
+#include "quest_types.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Binary quest database that is memory-mapped and searched in place.
+ *
+ * Written by generateQuestJson next to quests.json, so loading the quest database needs no
+ * parsing. All values are little-endian 32-bit integers:
+ *
+ * - header: magic "GDQC", version, quest count, locale count, string pool offset and size,
+ *   then the 64-bit size and the 16-byte MD5 digest of the quests.json written with it (to
+ *   detect a replaced JSON file, even one of the same size);
+ * - locale table: one 4-byte tag per language, "enUS" first;
+ * - quest hashes, sorted ascending;
+ * - one record per quest: flags, then the pool offsets of chapter and quest name per locale;
+ * - string pool: each distinct name once, as its UTF-8 length followed by the bytes.
+ */
+class QuestCatalog
+{
+public:
+    /// Quest flags stored in the catalog.
+    enum Flag : quint32
+    {
+        Bounty = 1,      ///< A bounty quest, not shown in the tracker.
+        Incomplete = 2,  ///< Chapter or quest name is missing.
+    };
+
+    /// "GDQC" as a little-endian integer.
+    static constexpr quint32 magic = 0x43514447;
+    /// Current format version.
+    static constexpr quint32 version = 2;
+
+    QuestCatalog() = default;
+    QuestCatalog(const QuestCatalog&) = delete;
+    QuestCatalog& operator=(const QuestCatalog&) = delete;
+
+    /**
+     * @brief Returns the flags of a quest from its English names.
+     */
+    static quint32 flagsOf(const QuestInfo& info)
+    {
+        quint32 flags = 0;
+        if (info.QuestName.contains("Bounty:"))
+            flags |= Bounty;
+        if (info.Chapter.isEmpty() || info.QuestName.isEmpty())
+            flags |= Incomplete;
+        return flags;
+    }
+
+    /**
+     * @brief Returns the names of a quest in a language.
+     *
+     * Bounties keep their English names in every language, as they are recognized by them.
+     */
+    static LocalizedNames namesOf(const QuestInfo& info, const QString& locale)
+    {
+        return (flagsOf(info) & Bounty) ? LocalizedNames{info.Chapter, info.QuestName} : info.names(locale);
+    }
+
+    /**
+     * @brief Returns the catalog path that belongs to a quests.json path.
+     */
+    static QString pathFor(const QString& jsonPath);
+
+    /**
+     * @brief Writes a catalog.
+     *
+     * @param path The catalog file to create or replace.
+     * @param quests The quests keyed by hash; English names in Chapter/QuestName, other languages in Localized.
+     * @param jsonSize Size of the quests.json file written with the catalog.
+     * @param jsonMd5 MD5 digest (16 raw bytes) of that quests.json file.
+     * @return True if the file was written successfully; otherwise false.
+     */
+    static bool write(const QString& path, const QMap<quint32, QuestInfo>& quests, qint64 jsonSize, const QByteArray& jsonMd5);
+
+    /**
+     * @brief Maps a catalog file, replacing any catalog opened before.
+     *
+     * Fails without throwing, so the caller can fall back to the JSON database, if the file is
+     * missing, malformed, of another version, or was not written with the current @p jsonPath.
+     * The JSON file is only read to compare its digest if its size matches.
+     *
+     * @param path The catalog file.
+     * @param jsonPath The quests.json it belongs to; not checked if empty or missing.
+     * @return True if the catalog can be used.
+     */
+    bool open(const QString& path, const QString& jsonPath = QString());
+
+    /// Returns true if a catalog is open.
+    bool isOpen() const { return base != nullptr; }
+
+    /// Number of quests.
+    int count() const { return int(questCount); }
+
+    /// Locale tags of the languages in the catalog, "enUS" first.
+    QStringList locales() const;
+
+    /// Returns the index of a locale for name lookups, or 0 (English) if it is not in the catalog.
+    int localeIndex(const QString& locale) const;
+
+    /**
+     * @brief Finds a quest by hash with a binary search.
+     *
+     * @return The quest's index, or -1 if it is not in the catalog.
+     */
+    int find(quint32 questHash) const;
+
+    /// Hash of the quest at @p index.
+    quint32 hashAt(int index) const;
+    /// Flags of the quest at @p index.
+    quint32 flags(int index) const;
+    /// Chapter name of the quest at @p index in the language at @p locale.
+    QString chapter(int index, int locale = 0) const;
+    /// Quest name of the quest at @p index in the language at @p locale.
+    QString questName(int index, int locale = 0) const;
+
+private:
+    quint32 readUInt(quint32 offset) const;
+    QString poolString(quint32 offset) const;
+    quint32 recordField(int index, int field) const;
+
+    QFile file;                   ///< The open catalog file.
+    const char* base = nullptr;   ///< Catalog contents (mapped, or pointing into buffer).
+    quint32 size = 0;             ///< Size of the catalog in bytes.
+    QByteArray buffer;            ///< Catalog contents if the file could not be mapped.
+    quint32 questCount = 0;       ///< Number of quests.
+    quint32 localeCount = 0;      ///< Number of languages.
+    quint32 hashesOffset = 0;     ///< Offset of the sorted hash array.
+    quint32 recordsOffset = 0;    ///< Offset of the quest records.
+    quint32 poolOffset = 0;       ///< Offset of the string pool.
+    quint32 poolSize = 0;         ///< Size of the string pool.
+};
+
+#endif // QUEST_CATALOG_H
@@ -0,0 +1,178 @@
+#include "quest_catalog.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QtEndian>
+
+namespace
+{
+    void silentMessageHandler(QtMsgType, const QMessageLogContext&, const QString&) {}
+
+    int failures = 0;
+
+    void check(bool ok, const QString& what)
+    {
+        if (ok)
+            return;
+
+        QTextStream(stderr) << "FAIL: " << what << Qt::endl;
+        failures++;
+    }
+
+    bool writeFile(const QString& path, const QByteArray& bytes)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(bytes) == bytes.size();
+    }
+
+    QByteArray readFile(const QString& path)
+    {
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    }
+
+    // Quests with English names, some in other languages, bounties, an incomplete quest and shared names
+    QMap<quint32, QuestInfo> makeQuests(QRandomGenerator& rng)
+    {
+        QMap<quint32, QuestInfo> quests;
+        while (quests.size() < 300) {
+            const int i = quests.size();
+            QuestInfo& info = quests[rng.generate()];
+            info.Chapter = QString("Act %1").arg(i % 7);
+            info.QuestName = i % 10 == 0 ? QString("Bounty: Slay %1").arg(i) : QString("Quest %1").arg(i);
+            if (i % 3 == 0)
+                info.Localized.insert("deDE", {QString("Akt %1").arg(i % 7), QString("Aufgabe %1").arg(i)});
+            if (i % 5 == 0)
+                info.Localized.insert("frFR", {QString("Acte %1").arg(i % 7), QString::fromUtf8("Qu\xC3\xAAte %1").arg(i)});
+            if (i == 4)
+                info.QuestName.clear();
+        }
+        return quests;
+    }
+
+    bool opens(const QString& catalogPath, const QString& jsonPath = QString())
+    {
+        QuestCatalog catalog;
+        return catalog.open(catalogPath, jsonPath);
+    }
+}
+
+int main()
+{
+    // Rejected catalogs are logged
+    qInstallMessageHandler(silentMessageHandler);
+
+    QTextStream out(stdout);
+    QRandomGenerator rng(20241017);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        QTextStream(stderr) << "Could not create a temporary directory" << Qt::endl;
+        return 1;
+    }
+    const QString jsonPath = dir.filePath("quests.json");
+    const QString catalogPath = QuestCatalog::pathFor(jsonPath);
+    check(catalogPath == dir.filePath("quests.qcat"), "catalog path is not next to quests.json");
+
+    // The catalog only looks at the size and digest of the JSON file, not at its contents
+    const QMap<quint32, QuestInfo> quests = makeQuests(rng);
+    const QByteArray json = "{ \"quests\": \"stand-in for the generated quests.json\" }\n";
+    const QByteArray jsonMd5 = QCryptographicHash::hash(json, QCryptographicHash::Md5);
+    check(writeFile(jsonPath, json), "quests.json could not be written");
+
+    check(!QuestCatalog::write(catalogPath, quests, json.size(), QByteArray("md5")), "catalog written without a valid digest");
+    check(QuestCatalog::write(catalogPath, quests, json.size(), jsonMd5), "catalog could not be written");
+
+    // Reopening the catalog gives back every quest, with flags and names per language
+    QuestCatalog catalog;
+    check(catalog.open(catalogPath, jsonPath), "written catalog was rejected");
+    check(catalog.count() == quests.size(), "wrong quest count");
+    check(catalog.locales() == QStringList({"enUS", "deDE", "frFR"}), "wrong languages");
+    check(catalog.localeIndex("deDE") == 1 && catalog.localeIndex("xxXX") == 0, "wrong locale index");
+
+    const QStringList locales = catalog.locales();
+    for (auto it = quests.cbegin(); it != quests.cend(); ++it) {
+        const QString what = QString("quest 0x%1").arg(it.key(), 8, 16, QChar('0'));
+        const int index = catalog.find(it.key());
+        check(index >= 0 && catalog.hashAt(index) == it.key(), what + ": not found");
+        if (index < 0)
+            continue;
+
+        check(catalog.flags(index) == QuestCatalog::flagsOf(it.value()), what + ": flags differ");
+        for (int locale = 0; locale < locales.size(); locale++) {
+            const LocalizedNames names = QuestCatalog::namesOf(it.value(), locales[locale]);
+            check(catalog.chapter(index, locale) == names.Chapter && catalog.questName(index, locale) == names.QuestName,
+                  what + ": names in " + locales[locale] + " differ");
+        }
+    }
+
+    // Hashes that are not in the catalog are not found
+    int misses = 0;
+    while (misses < 10000) {
+        const quint32 hash = rng.generate();
+        if (quests.contains(hash))
+            continue;
+        check(catalog.find(hash) == -1, QString("0x%1 found but not in the catalog").arg(hash, 8, 16, QChar('0')));
+        misses++;
+    }
+
+    // A quests.json that is missing is not checked; a replaced one is detected by size or digest
+    check(opens(catalogPath), "catalog rejected without quests.json");
+    check(opens(catalogPath, dir.filePath("missing.json")), "catalog rejected for a missing quests.json");
+
+    QByteArray sameSize = json;
+    sameSize[2] = '!';
+    check(writeFile(jsonPath, sameSize) && !opens(catalogPath, jsonPath), "catalog accepted for a same-size quests.json");
+    check(writeFile(jsonPath, json + " ") && !opens(catalogPath, jsonPath), "catalog accepted for a larger quests.json");
+    check(writeFile(jsonPath, json) && opens(catalogPath, jsonPath), "catalog rejected after restoring quests.json");
+
+    // Truncated and malformed catalogs are rejected
+    const QByteArray bytes = readFile(catalogPath);
+    const QString badPath = dir.filePath("bad.qcat");
+    for (int length = 0; length < bytes.size(); length += (length < 64 ? 1 : 97))
+        check(writeFile(badPath, bytes.left(length)) && !opens(badPath), QString("catalog truncated to %1 bytes was accepted").arg(length));
+    check(writeFile(badPath, bytes + '\0') && !opens(badPath), "catalog with trailing data was accepted");
+
+    auto withUInt = [&bytes](int offset, quint32 value) {
+        QByteArray changed = bytes;
+        qToLittleEndian<quint32>(value, changed.data() + offset);
+        return changed;
+    };
+    check(writeFile(badPath, withUInt(0, 0x12345678)) && !opens(badPath), "catalog with a bad magic was accepted");
+    check(writeFile(badPath, withUInt(4, QuestCatalog::version - 1)) && !opens(badPath), "catalog of an older version was accepted");
+    check(writeFile(badPath, withUInt(8, 0xFFFFFFFF)) && !opens(badPath), "catalog with a huge quest count was accepted");
+    check(writeFile(badPath, withUInt(12, 0xFFFFFFFF)) && !opens(badPath), "catalog with a huge locale count was accepted");
+    check(writeFile(badPath, withUInt(12, 0)) && !opens(badPath), "catalog without languages was accepted");
+    check(writeFile(badPath, withUInt(20, 0)) && !opens(badPath), "catalog with a wrong pool size was accepted");
+
+    // Flipped bits are either rejected or read within bounds, which AddressSanitizer builds check
+    int accepted = 0;
+    for (int round = 0; round < 500; round++) {
+        QByteArray corrupt = bytes;
+        for (int flips = 1 + int(rng.bounded(4)); flips > 0; flips--) {
+            const int at = int(rng.bounded(corrupt.size()));
+            corrupt[at] = char(corrupt.at(at) ^ (1 << rng.bounded(8)));
+        }
+        if (!writeFile(badPath, corrupt))
+            continue;
+
+        QuestCatalog corrupted;
+        if (!corrupted.open(badPath))
+            continue;
+
+        accepted++;
+        for (int i = 0; i < corrupted.count(); i++) {
+            for (int locale = 0; locale < corrupted.locales().size(); locale++) {
+                corrupted.chapter(i, locale);
+                corrupted.questName(i, locale);
+            }
+        }
+        corrupted.find(rng.generate());
+    }
+
+    out << quests.size() << " quests, " << accepted << " corrupt catalogs read in bounds, " << failures << " failures" << Qt::endl;
+    return failures == 0 ? 0 : 1;
+}
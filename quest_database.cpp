@@ -0,0 +1,262 @@
+#include "quest_database.h"
+#include "jsonparser.h"
+#include "perf_counters.h"
+#include "perfect_hash.h"
+#include "quest_catalog.h"
+#include "trace.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+
+#ifdef GDQT_EMBEDDED_QUESTS
+#include "embedded_quests.h"
+#include <iterator>
+#endif
+
+namespace
+{
+    // Multiplier of the Fibonacci hashing that spreads the quest hashes over the table
+    constexpr quint32 slotMultiplier = 0x9E3779B9u;
+
+    /**
+     * @brief Identifies the files a database was loaded from, to notice when they change.
+     */
+    struct FileStamp
+    {
+        QString jsonPath;
+        qint64 jsonSize = -1;
+        qint64 jsonModified = 0;
+        qint64 catalogSize = -1;
+        qint64 catalogModified = 0;
+
+        bool operator==(const FileStamp &other) const
+        {
+            return jsonPath == other.jsonPath && jsonSize == other.jsonSize && jsonModified == other.jsonModified
+                   && catalogSize == other.catalogSize && catalogModified == other.catalogModified;
+        }
+    };
+
+    FileStamp stampOf(const QString &jsonPath)
+    {
+        FileStamp stamp;
+        stamp.jsonPath = jsonPath;
+
+        const QFileInfo json(jsonPath);
+        if (json.exists()) {
+            stamp.jsonSize = json.size();
+            stamp.jsonModified = json.lastModified().toMSecsSinceEpoch();
+        }
+
+        const QFileInfo catalog(QuestCatalog::pathFor(jsonPath));
+        if (!jsonPath.isEmpty() && catalog.exists()) {
+            stamp.catalogSize = catalog.size();
+            stamp.catalogModified = catalog.lastModified().toMSecsSinceEpoch();
+        }
+
+        return stamp;
+    }
+
+    // The built-in database is used for a missing quests.json or one it was compiled from
+    bool matchesBuiltIn(const QString &jsonPath)
+    {
+#ifdef GDQT_EMBEDDED_QUESTS
+        QFile file(jsonPath);
+        if (jsonPath.isEmpty() || !file.exists())
+            return true;
+
+        // Only a file of the same size is read and compared
+        if (file.size() != EmbeddedQuests::sourceSize || !file.open(QIODevice::ReadOnly))
+            return false;
+
+        return QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5).toHex() == EmbeddedQuests::sourceMd5;
+#else
+        Q_UNUSED(jsonPath);
+        return false;
+#endif
+    }
+
+    QMutex residentMutex;
+    std::shared_ptr<const QuestDatabase> residentDatabase;
+    FileStamp residentStamp;
+}
+
+std::shared_ptr<const QuestDatabase> QuestDatabase::load(const QString& jsonPath)
+{
+    const FileStamp stamp = stampOf(jsonPath);
+
+    QMutexLocker locker(&residentMutex);
+    if (residentDatabase && residentStamp == stamp) {
+        PerfCounters::addLookups("Resident quest database", 1, 0);
+        return residentDatabase;
+    }
+    PerfCounters::addLookups("Resident quest database", 0, 1);
+
+    TraceZone zone("QuestDatabase::load");
+
+    std::shared_ptr<QuestDatabase> database(new QuestDatabase);
+
+    // The catalog is only used if it was written together with the current quests.json
+    QuestCatalog catalog;
+    if (!jsonPath.isEmpty() && catalog.open(QuestCatalog::pathFor(jsonPath), jsonPath)) {
+        database->loadCatalog(catalog);
+        database->buildTable();
+    } else if (matchesBuiltIn(jsonPath)) {
+        database->loadBuiltIn();
+    } else {
+        JsonParser parser;
+        parser.read(jsonPath); // Throws QException if the quest data can't be read
+        database->loadJson(parser);
+        database->buildTable();
+    }
+    zone.setItems(database->count());
+
+    qDebug() << "Quest database loaded with" << database->count() << "quests in" << database->locales().size() << "languages.";
+
+    residentDatabase = database;
+    residentStamp = stamp;
+    return residentDatabase;
+}
+
+bool QuestDatabase::hasBuiltIn()
+{
+#ifdef GDQT_EMBEDDED_QUESTS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void QuestDatabase::invalidate()
+{
+    QMutexLocker locker(&residentMutex);
+    residentDatabase.reset();
+    residentStamp = FileStamp();
+}
+
+int QuestDatabase::localeIndex(const QString& locale) const
+{
+    const int index = localeTags.indexOf(locale);
+    return index < 0 ? 0 : index;
+}
+
+int QuestDatabase::find(quint32 questHash) const
+{
+    // The built-in database is ordered by its perfect hash, so the slot is the quest index
+    if (bucketSeeds) {
+        if (hashes.isEmpty())
+            return -1;
+
+        const quint32 seed = bucketSeeds[PerfectHash::bucketOf(questHash, bucketCount)];
+        const int slot = int(PerfectHash::slotOf(questHash, seed, quint32(hashes.size())));
+        return hashes[slot] == questHash ? slot : -1;
+    }
+
+    const int mask = slotIndexes.size() - 1;
+    int slot = int((questHash * slotMultiplier) >> slotShift);
+
+    // The table is at most half full, so probing always reaches an empty slot
+    while (slotIndexes[slot] >= 0) {
+        if (slotHashes[slot] == questHash)
+            return slotIndexes[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    return -1;
+}
+
+void QuestDatabase::loadCatalog(const QuestCatalog& catalog)
+{
+    localeTags = catalog.locales();
+
+    const int questCount = catalog.count();
+    hashes.reserve(questCount);
+    questFlags.reserve(questCount);
+    questNames.reserve(questCount * localeTags.size());
+
+    // The catalog already holds the names per language, with bounties kept in English
+    for (int i = 0; i < questCount; i++) {
+        hashes.append(catalog.hashAt(i));
+        questFlags.append(catalog.flags(i));
+        for (int locale = 0; locale < localeTags.size(); locale++)
+            questNames.append(LocalizedNames{catalog.chapter(i, locale), catalog.questName(i, locale)});
+    }
+}
+
+void QuestDatabase::loadJson(const JsonParser& parser)
+{
+    // English first, like in the catalog
+    localeTags = parser.locales;
+    localeTags.removeAll("enUS");
+    localeTags.prepend("enUS");
+
+    hashes.reserve(parser.questData.size());
+    questFlags.reserve(parser.questData.size());
+    questNames.reserve(parser.questData.size() * localeTags.size());
+
+    for (auto it = parser.questData.cbegin(); it != parser.questData.cend(); ++it) {
+        bool ok = false;
+        const quint32 hash = it.key().toUInt(&ok, 0);
+        if (!ok)
+            continue;
+
+        hashes.append(hash);
+        questFlags.append(QuestCatalog::flagsOf(it.value()));
+        for (const QString &locale : std::as_const(localeTags))
+            questNames.append(QuestCatalog::namesOf(it.value(), locale));
+    }
+}
+
+void QuestDatabase::loadBuiltIn()
+{
+#ifdef GDQT_EMBEDDED_QUESTS
+    for (const char *locale : EmbeddedQuests::locales)
+        localeTags.append(QString::fromLatin1(locale));
+
+    // The names point into the executable's data instead of being copied
+    QVector<QString> texts;
+    texts.reserve(int(std::size(EmbeddedQuests::texts)));
+    for (const EmbeddedQuests::Text &text : EmbeddedQuests::texts)
+        texts.append(QString::fromRawData(reinterpret_cast<const QChar*>(text.data), text.size));
+
+    hashes.reserve(EmbeddedQuests::questCount);
+    questFlags.reserve(EmbeddedQuests::questCount);
+    questNames.reserve(EmbeddedQuests::questCount * EmbeddedQuests::localeCount);
+
+    for (int i = 0; i < EmbeddedQuests::questCount; i++) {
+        hashes.append(EmbeddedQuests::hashes[i]);
+        questFlags.append(EmbeddedQuests::flags[i]);
+        for (int locale = 0; locale < EmbeddedQuests::localeCount; locale++)
+            questNames.append(LocalizedNames{texts[EmbeddedQuests::names[i][locale * 2]], texts[EmbeddedQuests::names[i][locale * 2 + 1]]});
+    }
+
+    bucketSeeds = EmbeddedQuests::seeds;
+    bucketCount = EmbeddedQuests::bucketCount;
+#endif
+}
+
+void QuestDatabase::buildTable()
+{
+    // Power-of-two table at most half full
+    int bits = 4;
+    while ((1 << bits) < hashes.size() * 2)
+        bits++;
+
+    slotShift = 32 - bits;
+    slotHashes.fill(0, 1 << bits);
+    slotIndexes.fill(-1, 1 << bits);
+
+    const int mask = slotIndexes.size() - 1;
+    for (int i = 0; i < hashes.size(); i++) {
+        int slot = int((hashes[i] * slotMultiplier) >> slotShift);
+        while (slotIndexes[slot] >= 0 && slotHashes[slot] != hashes[i])
+            slot = (slot + 1) & mask;
+
+        // A later duplicate replaces the earlier one, as in a map keyed by hash
+        slotHashes[slot] = hashes[i];
+        slotIndexes[slot] = i;
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef QUEST_DATABASE_H
+#define QUEST_DATABASE_H
+
+#include "quest_types.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+
+class JsonParser;
+class QuestCatalog;
+
+/**
+ * @brief Process-wide quest database, kept in memory between refreshes.
+ *
+ * Loaded from the binary catalog next to quests.json if it is current, else from the built-in
+ * database compiled from resources/quests.json if the file is missing or identical to it, else
+ * from the JSON file, and only loaded again once either file changes. Quests are found by their numeric hash in an
+ * open-addressing table, and their names are stored once per language, so a lookup while a
+ * quests.gdd file is streamed neither formats strings nor copies QuestInfo values.
+ */
+class QuestDatabase
+{
+public:
+    QuestDatabase(const QuestDatabase&) = delete;
+    QuestDatabase& operator=(const QuestDatabase&) = delete;
+
+    /**
+     * @brief Returns the database for @p jsonPath, loading it only if needed.
+     *
+     * The resident database is reused as long as the path and the size and modification time of
+     * quests.json and its catalog are unchanged. Thread-safe. Throws QException if the quest
+     * data cannot be read.
+     *
+     * @param jsonPath Path to quests.json; empty for the built-in database.
+     * @return The loaded database; stays valid while the caller holds it, even if it is replaced.
+     */
+    static std::shared_ptr<const QuestDatabase> load(const QString& jsonPath);
+
+    /**
+     * @brief Returns true if the executable has a built-in quest database (GDQT_EMBED_QUESTS).
+     */
+    static bool hasBuiltIn();
+
+    /**
+     * @brief Drops the resident database, so the next load reads the files again.
+     */
+    static void invalidate();
+
+    /// Number of quests.
+    int count() const { return hashes.size(); }
+
+    /// Locale tags of the languages in the database, "enUS" first.
+    const QStringList& locales() const { return localeTags; }
+
+    /// Returns the index of a locale for name lookups, or 0 (English) if it is not in the database.
+    int localeIndex(const QString& locale) const;
+
+    /**
+     * @brief Finds a quest by hash.
+     *
+     * @return The quest's index, or -1 if it is not in the database.
+     */
+    int find(quint32 questHash) const;
+
+    /// Hash of the quest at @p index.
+    quint32 hashAt(int index) const { return hashes[index]; }
+    /// Flags of the quest at @p index (see QuestCatalog::Flag).
+    quint32 flags(int index) const { return questFlags[index]; }
+    /// Names of the quest at @p index in the language at @p locale.
+    const LocalizedNames& names(int index, int locale = 0) const { return questNames[index * localeTags.size() + locale]; }
+
+private:
+    QuestDatabase() = default;
+
+    void loadCatalog(const QuestCatalog& catalog);
+    void loadJson(const JsonParser& parser);
+    void loadBuiltIn();
+    void buildTable();
+
+    QStringList localeTags;                ///< Languages, "enUS" first.
+    QVector<quint32> hashes;               ///< Quest hash per quest.
+    QVector<quint32> questFlags;           ///< Flags per quest.
+    QVector<LocalizedNames> questNames;    ///< Names per quest and language, quest-major.
+    QVector<quint32> slotHashes;           ///< Quest hash per table slot.
+    QVector<int> slotIndexes;              ///< Quest index per table slot, -1 if empty.
+    int slotShift = 32;                    ///< 32 minus log2 of the table size.
+    const quint32* bucketSeeds = nullptr;  ///< Perfect hash seeds of the built-in database, which has no table.
+    quint32 bucketCount = 0;               ///< Number of perfect hash seeds.
+};
+
+#endif // QUEST_DATABASE_H
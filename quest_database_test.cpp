@@ -0,0 +1,183 @@
+#include "quest_catalog.h"
+#include "quest_database.h"
+
+#include <QCryptographicHash>
+#include <QException>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+namespace
+{
+    void silentMessageHandler(QtMsgType, const QMessageLogContext&, const QString&) {}
+
+    int failures = 0;
+
+    void check(bool ok, const QString& what)
+    {
+        if (ok)
+            return;
+
+        QTextStream(stderr) << "FAIL: " << what << Qt::endl;
+        failures++;
+    }
+
+    QString hashKey(quint32 hash)
+    {
+        return QString("0x%1").arg(hash, 8, 16, QChar('0'));
+    }
+
+    // Quests with English names, some in other languages, bounties and an incomplete quest
+    QMap<quint32, QuestInfo> makeQuests(QRandomGenerator& rng)
+    {
+        QMap<quint32, QuestInfo> quests;
+        while (quests.size() < 500) {
+            const int i = quests.size();
+            QuestInfo& info = quests[rng.generate()];
+            info.Chapter = QString("Act %1").arg(i % 7);
+            info.QuestName = i % 10 == 0 ? QString("Bounty: Slay %1").arg(i) : QString("Quest %1").arg(i);
+            if (i % 3 == 0)
+                info.Localized.insert("deDE", {QString("Akt %1").arg(i % 7), QString("Aufgabe %1").arg(i)});
+            if (i % 5 == 0)
+                info.Localized.insert("ruRU", {QString::fromUtf8("\xD0\x90\xD0\xBA\xD1\x82 %1").arg(i % 7), QString("Zadanie %1").arg(i)});
+            if (i == 4)
+                info.Chapter.clear();
+        }
+        return quests;
+    }
+
+    // The layout generateQuestJson writes
+    QByteArray toJson(const QMap<quint32, QuestInfo>& quests)
+    {
+        QJsonObject root;
+        for (auto it = quests.cbegin(); it != quests.cend(); ++it) {
+            QJsonObject quest;
+            quest["Chapter"] = it->Chapter;
+            quest["QuestName"] = it->QuestName;
+
+            QJsonObject localized;
+            for (auto locale = it->Localized.cbegin(); locale != it->Localized.cend(); ++locale)
+                localized[locale.key()] = QJsonObject{{"Chapter", locale->Chapter}, {"QuestName", locale->QuestName}};
+            if (!localized.isEmpty())
+                quest["Localized"] = localized;
+
+            root[hashKey(it.key())] = quest;
+        }
+        return QJsonDocument(root).toJson();
+    }
+
+    bool writeFile(const QString& path, const QByteArray& bytes)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(bytes) == bytes.size();
+    }
+
+    bool writeCatalog(const QString& jsonPath, const QMap<quint32, QuestInfo>& quests, const QByteArray& json)
+    {
+        return QuestCatalog::write(QuestCatalog::pathFor(jsonPath), quests, json.size(), QCryptographicHash::hash(json, QCryptographicHash::Md5));
+    }
+
+    // Every quest is found with its flags and names in every language, and absent hashes are not
+    void compare(const QuestDatabase& database, const QMap<quint32, QuestInfo>& quests, const QString& source, QRandomGenerator& rng)
+    {
+        check(database.count() == quests.size(), source + ": wrong quest count");
+        check(database.locales() == QStringList({"enUS", "deDE", "ruRU"}), source + ": wrong languages");
+
+        const QStringList locales = database.locales();
+        for (auto it = quests.cbegin(); it != quests.cend(); ++it) {
+            const QString what = source + ", quest " + hashKey(it.key());
+            const int index = database.find(it.key());
+            check(index >= 0 && database.hashAt(index) == it.key(), what + ": not found");
+            if (index < 0)
+                continue;
+
+            check(database.flags(index) == QuestCatalog::flagsOf(it.value()), what + ": flags differ");
+            for (const QString& locale : locales) {
+                const LocalizedNames expected = QuestCatalog::namesOf(it.value(), locale);
+                const LocalizedNames& names = database.names(index, database.localeIndex(locale));
+                check(names.Chapter == expected.Chapter && names.QuestName == expected.QuestName, what + ": names in " + locale + " differ");
+            }
+        }
+
+        int misses = 0;
+        while (misses < 10000) {
+            const quint32 hash = rng.generate();
+            if (quests.contains(hash))
+                continue;
+            check(database.find(hash) == -1, source + ": " + hashKey(hash) + " found but not in the database");
+            misses++;
+        }
+    }
+}
+
+int main()
+{
+    // Loading logs the source of every database
+    qInstallMessageHandler(silentMessageHandler);
+
+    QTextStream out(stdout);
+    QRandomGenerator rng(20241017);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        QTextStream(stderr) << "Could not create a temporary directory" << Qt::endl;
+        return 1;
+    }
+    const QString jsonPath = dir.filePath("quests.json");
+
+    QMap<quint32, QuestInfo> quests = makeQuests(rng);
+    QByteArray json = toJson(quests);
+    check(writeFile(jsonPath, json), "quests.json could not be written");
+
+    try {
+        // Without a catalog the JSON file is parsed
+        const std::shared_ptr<const QuestDatabase> fromJson = QuestDatabase::load(jsonPath);
+        compare(*fromJson, quests, "JSON", rng);
+
+        // Unchanged files keep the resident database
+        check(QuestDatabase::load(jsonPath) == fromJson, "unchanged files loaded again");
+
+        // A catalog written next to the JSON replaces it and gives the same lookups
+        check(writeCatalog(jsonPath, quests, json), "catalog could not be written");
+        const std::shared_ptr<const QuestDatabase> fromCatalog = QuestDatabase::load(jsonPath);
+        check(fromCatalog != fromJson, "new catalog did not replace the resident database");
+        compare(*fromCatalog, quests, "catalog", rng);
+        check(QuestDatabase::load(jsonPath) == fromCatalog, "unchanged catalog loaded again");
+
+        // The catalog alone suffices, as a missing quests.json is not checked against it
+        check(QFile::remove(jsonPath), "quests.json could not be removed");
+        const std::shared_ptr<const QuestDatabase> catalogOnly = QuestDatabase::load(jsonPath);
+        check(catalogOnly != fromCatalog, "removing quests.json did not replace the resident database");
+        compare(*catalogOnly, quests, "catalog without JSON", rng);
+
+        // A regenerated quests.json replaces the resident database, and the outdated catalog is ignored
+        quests.first().QuestName += " (renamed)";
+        json = toJson(quests);
+        check(writeFile(jsonPath, json), "quests.json could not be rewritten");
+        const std::shared_ptr<const QuestDatabase> changed = QuestDatabase::load(jsonPath);
+        check(changed != catalogOnly, "changed quests.json did not replace the resident database");
+        compare(*changed, quests, "changed JSON", rng);
+
+        // The database replaced above stays valid for the callers still holding it
+        check(fromJson->count() == quests.size() && fromJson->find(quests.firstKey()) >= 0, "replaced database no longer usable");
+
+        // invalidate() forces a reload even if nothing changed
+        QuestDatabase::invalidate();
+        const std::shared_ptr<const QuestDatabase> reloaded = QuestDatabase::load(jsonPath);
+        check(reloaded != changed, "invalidate() kept the resident database");
+        compare(*reloaded, quests, "reloaded JSON", rng);
+
+        // Another path is another database
+        const QString otherPath = dir.filePath("other.json");
+        check(writeFile(otherPath, json), "other.json could not be written");
+        check(QuestDatabase::load(otherPath) != reloaded, "another path reused the resident database");
+    } catch (const QException&) {
+        check(false, "quest database could not be loaded");
+    }
+
+    out << quests.size() << " quests, " << failures << " failures" << Qt::endl;
+    return failures == 0 ? 0 : 1;
+}
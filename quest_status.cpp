@@ -0,0 +1,123 @@
+#include "quest_status.h"
+#include "perf_counters.h"
+#include "quest_catalog.h"
+#include "trace.h"
+
+#include <QDir>
+#include <QFile>
+
+void QuestStatusCollector::onQuest(quint32 id1, const UID &, quint32)
+{
+    m_questId = id1;
+    m_allCompleted = true;
+    m_anyStarted = false;
+}
+
+void QuestStatusCollector::onTask(quint32, const UID &, quint32 state, quint32)
+{
+    m_allCompleted = m_allCompleted && state == 3;
+    m_anyStarted = m_anyStarted || state == 3 || state == 2;
+}
+
+void QuestStatusCollector::onQuestEnd()
+{
+    const int index = m_database.find(m_questId);
+    if (index < 0) {
+        m_misses++;
+        return;
+    }
+    m_hits++;
+
+    // Skip processing if quest info is incomplete or matches a bounty quest
+    if (m_database.flags(index) & (QuestCatalog::Bounty | QuestCatalog::Incomplete))
+        return;
+
+    // Determine quest status based on task completion states
+    QuestStatus::Status questStatus;
+    if (m_allCompleted) {
+        questStatus = QuestStatus::Completed;
+    } else if (!m_anyStarted) {
+        questStatus = QuestStatus::NotCompleted;
+    } else {
+        questStatus = QuestStatus::InProgress;
+    }
+
+    // Keep the status by hash; names are attached in the display language afterwards
+    m_statuses.append({m_questId, m_difficulty, questStatus});
+    m_resolved++;
+}
+
+int resolveQuestStatus(const QString &levelsDirPath, const QuestDatabase &database, int locale, QuestData &questData)
+{
+    QVector<ResolvedStatus> statuses;
+    const int filesRead = resolveQuestStatus(levelsDirPath, database, statuses);
+    applyQuestNames(statuses, database, locale, questData);
+
+    return filesRead;
+}
+
+int resolveQuestStatus(const QString &levelsDirPath, const QuestDatabase &database, QVector<ResolvedStatus> &statuses)
+{
+    QuestsFile gddParser;
+    int filesRead = 0;
+
+    // Process each difficulty level and update quest data based on task states
+    for (const Difficulty &difficulty : Difficulty::getAllDifficulties()) {
+        QFile gddFile(QString("%1/%2/quests.gdd").arg(levelsDirPath, difficulty.name));
+
+        if (gddFile.exists()) {
+            TraceZone statusZone("resolveQuestStatus");
+            statusZone.setBytes(gddFile.size());
+
+            // Stream the file and resolve statuses on the fly instead of building the quest tree
+            QuestStatusCollector collector(database, difficulty.name, statuses);
+            gddParser.visit(gddFile.fileName(), collector);
+
+            statusZone.setItems(collector.resolvedCount());
+            PerfCounters::addLookups("Quest database lookups", collector.hits(), collector.misses());
+            filesRead++;
+        }
+    }
+
+    return filesRead;
+}
+
+void applyQuestNames(const QVector<ResolvedStatus> &statuses, const QuestDatabase &database, int locale, QuestData &questData)
+{
+    // Applied in file order, so a name shared by two quests ends up with the status read last
+    for (const ResolvedStatus &resolved : statuses) {
+        const int index = database.find(resolved.questHash);
+        if (index < 0)
+            continue;
+
+        const LocalizedNames &names = database.names(index, locale);
+        questData.setStatus(names.Chapter, names.QuestName, resolved.difficulty, resolved.status);
+    }
+}
+
+QStringList findCharacters(const QString &saveDirPath)
+{
+    QStringList characterList;
+    QDir saveDir(saveDirPath);
+
+    // List available characters by checking subdirectories for expected structure
+    if (saveDir.exists()) {
+        const QStringList subDirs = saveDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+        for (const QString &dir : subDirs) {
+            QDir characterDir(saveDir.filePath(dir + "/levels_world001.map"));
+
+            // Append character to list if any difficulty folder exists
+            if (characterDir.exists("Normal") || characterDir.exists("Elite") || characterDir.exists("Ultimate")) {
+                characterList.append(dir);
+            }
+        }
+    }
+
+    return characterList;
+}
+
+QString characterLevelsPath(const QString &saveDirPath, const QString &character)
+{
+    return saveDirPath + "/" + character + "/levels_world001.map/";
+}
@@ -0,0 +1,125 @@
+#ifndef QUEST_STATUS_H
+#define QUEST_STATUS_H
+
+#include "gdd_parser.h"
+#include "quest_database.h"
+#include "quest_types.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief Status of one quest in one difficulty, by quest hash rather than by name.
+ *
+ * Kept after a refresh, so the table can be shown in another language without reading the
+ * quests files again (see applyQuestNames).
+ */
+struct ResolvedStatus
+{
+    quint32 questHash;
+    QString difficulty;
+    QuestStatus::Status status;
+};
+
+/**
+ * @brief Resolves quest statuses while a quests.gdd file is streamed, without building the quest tree.
+ *
+ * Only the task states are needed, so tokens and objectives are skipped and every quest is
+ * resolved in @ref onQuestEnd from two running flags.
+ */
+class QuestStatusCollector : public QuestsVisitor
+{
+public:
+    /**
+     * @brief Constructs a collector appending to @p statuses.
+     *
+     * @param database Quest database the quests are looked up in.
+     * @param difficulty Name of the difficulty the streamed file belongs to.
+     * @param statuses Receives the status of every known quest, in file order.
+     */
+    QuestStatusCollector(const QuestDatabase &database, const QString &difficulty, QVector<ResolvedStatus> &statuses)
+        : m_database(database), m_difficulty(difficulty), m_statuses(statuses) {}
+
+    bool wantsTokens() const override { return false; }
+    bool wantsObjectives() const override { return false; }
+
+    void onQuest(quint32 id1, const UID &, quint32) override;
+    void onTask(quint32, const UID &, quint32 state, quint32) override;
+    void onQuestEnd() override;
+
+    /// Number of quests whose status was appended.
+    int resolvedCount() const { return m_resolved; }
+    /// Number of quests of the save found in the quest database.
+    quint64 hits() const { return m_hits; }
+    /// Number of quests of the save missing from the quest database.
+    quint64 misses() const { return m_misses; }
+
+private:
+    const QuestDatabase &m_database;
+    const QString &m_difficulty;
+    QVector<ResolvedStatus> &m_statuses;
+    quint32 m_questId = 0;
+    bool m_allCompleted = true;
+    bool m_anyStarted = false;
+    int m_resolved = 0;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+};
+
+/**
+ * @brief Resolves the status of every known quest of one character in all difficulties.
+ *
+ * Difficulties without a quests.gdd file are skipped. Throws QException if a file cannot be
+ * read or decoded.
+ *
+ * @param levelsDirPath Path to the character's levels_world001.map folder.
+ * @param database Quest database the quests are looked up in.
+ * @param locale Index of the display language in the database (see QuestDatabase::localeIndex).
+ * @param questData Model that receives the resolved statuses.
+ * @return The number of quests files read.
+ */
+int resolveQuestStatus(const QString &levelsDirPath, const QuestDatabase &database, int locale, QuestData &questData);
+
+/**
+ * @brief Resolves the status of every known quest of one character in all difficulties, by quest hash.
+ *
+ * Difficulties without a quests.gdd file are skipped. Throws QException if a file cannot be
+ * read or decoded.
+ *
+ * @param levelsDirPath Path to the character's levels_world001.map folder.
+ * @param database Quest database the quests are looked up in.
+ * @param statuses Receives the statuses, in file order.
+ * @return The number of quests files read.
+ */
+int resolveQuestStatus(const QString &levelsDirPath, const QuestDatabase &database, QVector<ResolvedStatus> &statuses);
+
+/**
+ * @brief Fills @p questData with resolved statuses under the quest names in one language.
+ *
+ * Quests no longer in @p database, e.g. after quests.json was regenerated, are left out.
+ *
+ * @param statuses Statuses from resolveQuestStatus.
+ * @param database Quest database the names are taken from.
+ * @param locale Index of the display language in the database (see QuestDatabase::localeIndex).
+ * @param questData Model that receives the statuses.
+ */
+void applyQuestNames(const QVector<ResolvedStatus> &statuses, const QuestDatabase &database, int locale, QuestData &questData);
+
+/**
+ * @brief Lists the character folders of a save directory.
+ *
+ * A folder counts as a character if its levels_world001.map folder contains at least one
+ * difficulty folder.
+ *
+ * @param saveDirPath The main save folder.
+ * @return Folder names of the characters, in directory order.
+ */
+QStringList findCharacters(const QString &saveDirPath);
+
+/**
+ * @brief Returns the levels_world001.map folder of a character.
+ */
+QString characterLevelsPath(const QString &saveDirPath, const QString &character);
+
+#endif // QUEST_STATUS_H
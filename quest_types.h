@@ -0,0 +1,98 @@
+#ifndef QUEST_TYPES_H
+#define QUEST_TYPES_H
+
+#include <QMap>
+#include <QString>
+#include <QList>
+
+class QColor;
+
+// Difficluty
+
+enum class DifficultyLevel {
+    Normal,
+    Elite,
+    Ultimate
+};
+
+struct Difficulty {
+    DifficultyLevel level;
+    QString name;
+
+    Difficulty(DifficultyLevel lvl, const QString &nm) : level(lvl), name(nm) {}
+
+    static QList<Difficulty> getAllDifficulties() {
+        return {
+            {DifficultyLevel::Normal, "Normal"},
+            {DifficultyLevel::Elite, "Elite"},
+            {DifficultyLevel::Ultimate, "Ultimate"}
+        };
+    }
+};
+
+// Quests
+
+struct LocalizedNames
+{
+    QString Chapter;
+    QString QuestName;
+};
+
+struct QuestInfo
+{
+    QString Chapter;
+    QString QuestName;
+    // Names in other languages, keyed by locale tag (e.g. "deDE"); Chapter and QuestName are enUS
+    QMap<QString, LocalizedNames> Localized;
+
+    // Returns the names in the given language, falling back to English
+    LocalizedNames names(const QString &locale) const {
+        return Localized.value(locale, LocalizedNames{Chapter, QuestName});
+    }
+};
+
+struct QuestStatus {
+    enum Status {
+        NotCompleted,
+        InProgress,
+        Completed
+    };
+
+    Status status;
+
+    QuestStatus(Status s = NotCompleted) : status(s) {}
+
+    QString toString() const {
+        switch (status) {
+        case NotCompleted: return "Not completed";
+        case InProgress: return "In Progress";
+        case Completed: return "Completed";
+        default: return "Unknown";
+        }
+    }
+
+    // Defined in types.h, which depends on Qt GUI; headless code only needs the status text
+    QColor color() const;
+};
+
+class QuestData {
+public:
+    void setStatus(const QString &chapter, const QString &quest, const QString &difficulty, QuestStatus::Status status) {
+        data[chapter][quest][difficulty] = QuestStatus(status);
+    }
+
+    QuestStatus getStatus(const QString &chapter, const QString &quest, const QString &difficulty) const {
+        return data.value(chapter).value(quest).value(difficulty, QuestStatus(QuestStatus::NotCompleted));
+    }
+
+    // Итераторы для удобного доступа к данным (если нужно)
+    auto chapters() const { return data.keys(); }
+    auto quests(const QString &chapter) const { return data.value(chapter).keys(); }
+    auto difficulties(const QString &chapter, const QString &quest) const { return data.value(chapter).value(quest).keys(); }
+    auto allData() const { return data; }
+
+private:
+    QMap<QString, QMap<QString, QMap<QString, QuestStatus>>> data;
+};
+
+#endif // QUEST_TYPES_H
@@ -2,17 +2,30 @@
 #include "./ui_questtrackerwindow.h"
 #include "settings.h"
 #include "gdd_parser.h"
-#include "jsonparser.h"
+#include "quest_status.h"
+#include "quest_database.h"
 #include "utils.h"
 #include "version.h"
+#include "trace.h"
+#include "alloc_stats.h"
+#include "perf_counters.h"
 
 #include <QStandardItemModel>
 #include <QMessageBox>
-#include <QMutex>
 #include <QRegularExpression>
 #include <QFile>
 #include <QTextStream>
 #include <QApplication>
+#include <QHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QTableWidget>
+#include <QThreadPool>
+#include <QProgressDialog>
+#include <QThread>
+#include <QLocale>
 
 // Static member initialization
 QTextEdit* QuestTrackerWindow::textEditLogInstance = nullptr;
@@ -24,6 +37,16 @@ QuestTrackerWindow::QuestTrackerWindow(QWidget *parent)
     ui->setupUi(this);
     ui->tabQestsTracker->setCurrentIndex(0);
 
+    // Refresh shortly after the game saves; repeated writes within the delay cause a single refresh
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(100);
+    connect(m_refreshTimer, &QTimer::timeout, this, &QuestTrackerWindow::refreshData);
+
+    m_saveWatcher = new QFileSystemWatcher(this);
+    connect(m_saveWatcher, &QFileSystemWatcher::fileChanged, this, &QuestTrackerWindow::onSavePathChanged);
+    connect(m_saveWatcher, &QFileSystemWatcher::directoryChanged, this, &QuestTrackerWindow::onSavePathChanged);
+
     // Set window title with the application version
     QString title = QString("Grim Dawn Quests Tracker v%1.%2").arg(VERSION_MAJOR).arg(VERSION_MINOR);
     this->setWindowTitle(title);
@@ -31,6 +54,7 @@ QuestTrackerWindow::QuestTrackerWindow(QWidget *parent)
     // Initialize settings and logging setup
     initializeSettings();
     initializeLogging();
+    initializeDiagnostics();
 
     // Set up the filter proxy model to enable case-insensitive search across all columns
     proxyModel = new QSortFilterProxyModel(this);
@@ -49,6 +73,8 @@ QuestTrackerWindow::~QuestTrackerWindow()
 
 void QuestTrackerWindow::generateQuestJsonFile()
 {
+    TraceZone zone("QuestTrackerWindow::generateQuestJsonFile");
+
     QString directoryPath = ui->lineEditQstFilesPath->text();
 
     // Check if the directory path is specified
@@ -57,9 +83,25 @@ void QuestTrackerWindow::generateQuestJsonFile()
         return;
     }
 
+    // Show the parse progress; the dialog is window-modal, so setValue keeps the window responsive
+    QProgressDialog progressDialog("Parsing quest files...", "Cancel", 0, 0, this);
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(500);
+
+    // Remember whether the generation stopped because the user asked it to
+    bool cancelled = false;
+    auto progress = [&progressDialog, &cancelled](int parsed, int total) {
+        progressDialog.setMaximum(total);
+        progressDialog.setValue(parsed);
+        cancelled = progressDialog.wasCanceled();
+        return !cancelled;
+    };
+
     // Attempt to generate the quests JSON file from the specified directory
-    if (generateQuestJson(directoryPath)) {
+    if (generateQuestJson(directoryPath, QString(), progress)) {
         qInfo() << "The quests.json has been generated in the resources folder.";
+    } else if (cancelled) {
+        qInfo() << "Generation of quests.json was cancelled; the existing file was left unchanged.";
     } else {
         qCritical() << "Failed to generate quests.json. Please check the directory and try again.";
     }
@@ -67,6 +109,9 @@ void QuestTrackerWindow::generateQuestJsonFile()
 
 void QuestTrackerWindow::populateTableView(const QuestData &questData)
 {
+    TraceZone zone("QuestTrackerWindow::populateTableView");
+    AllocScope allocScope("populateTableView");
+
     // Create a new model with headers for quest details and difficulty statuses
     QStandardItemModel *tableModel = new QStandardItemModel(this);
     tableModel->setHorizontalHeaderLabels({"Chapter", "Quest", "Normal", "Elite", "Ultimate"});
@@ -93,7 +138,14 @@ void QuestTrackerWindow::populateTableView(const QuestData &questData)
         }
     }
 
+    zone.setItems(tableModel->rowCount());
+    PerfCounters::setGauge("Table rows", tableModel->rowCount());
+    PerfCounters::setGauge("Table items", qint64(tableModel->rowCount()) * tableModel->columnCount());
+
     // Assign the model to the proxy and enable sorting on the table view
+    TraceZone sortZone("QuestTrackerWindow::populateTableView/sort");
+    sortZone.setItems(tableModel->rowCount());
+
     proxyModel->setSourceModel(tableModel);
     ui->tableViewQuestsList->setSortingEnabled(true);
 
@@ -108,6 +160,8 @@ void QuestTrackerWindow::populateTableView(const QuestData &questData)
 
 void QuestTrackerWindow::filterTable(const QString &text)
 {
+    TraceZone zone("QuestTrackerWindow::filterTable");
+
     // Apply case-insensitive filtering to the table view using a regular expression
     QRegularExpression regex(text, QRegularExpression::CaseInsensitiveOption);
     proxyModel->setFilterRegularExpression(regex);
@@ -115,6 +169,9 @@ void QuestTrackerWindow::filterTable(const QString &text)
 
 void QuestTrackerWindow::refreshData()
 {
+    TraceZone zone("QuestTrackerWindow::refreshData");
+    AllocScope allocScope("refreshData");
+
     // Ensure a valid character is selected from the combo box
     int selectedIndex = ui->comboBoxCharacter->currentIndex();
     if (selectedIndex < 0 || selectedIndex >= m_originalCharacterNames.size()) {
@@ -123,54 +180,125 @@ void QuestTrackerWindow::refreshData()
     }
 
     QString characterFolder = m_originalCharacterNames[selectedIndex];
-    QString gddFilePath = m_settings->getSaveDirPath() + "/" + characterFolder + "/levels_world001.map/";
+    QString gddFilePath = characterLevelsPath(m_settings->getSaveDirPath(), characterFolder);
+
+    // Follow this character's saves from now on
+    watchQuestFiles(gddFilePath);
 
     QuestData questData;
-    QuestsFile gddParser;
-    JsonParser jsonParser;
 
     try {
-        // Parse quests JSON file and load data
-        jsonParser.read(m_settings->getQuestsFilePath());
-
-        // Process each difficulty level and update quest data based on task states
-        for (const Difficulty &difficulty : Difficulty::getAllDifficulties()) {
-            QFile gddFile(QString("%1/%2/quests.gdd").arg(gddFilePath, difficulty.name));
-
-            if (gddFile.exists()) {
-                gddParser.read(gddFile.fileName());
-
-                for (const Quest &quest : gddParser.quests.quests) {
-                    QString questIdStr = QString("0x%1").arg(quest.id1, 8, 16, QChar('0')).toLower();
-                    QuestInfo questInfo = jsonParser.questData.value(questIdStr);
-
-                    // Skip processing if quest info is incomplete or matches a bounty quest
-                    if (!questInfo.Chapter.isEmpty() && !questInfo.QuestName.isEmpty() && !questInfo.QuestName.contains("Bounty:")) {
-                        QuestStatus::Status questStatus;
-
-                        // Determine quest status based on task completion states
-                        if (std::all_of(quest.tasks.cbegin(), quest.tasks.cend(), [](const Task &task) { return task.state == 3; })) {
-                            questStatus = QuestStatus::Completed;
-                        } else if (std::none_of(quest.tasks.cbegin(), quest.tasks.cend(), [](const Task &task) { return task.state == 3 || task.state == 2; })) {
-                            questStatus = QuestStatus::NotCompleted;
-                        } else {
-                            questStatus = QuestStatus::InProgress;
-                        }
-
-                        // Update the quest data model with the quest status
-                        questData.setStatus(questInfo.Chapter, questInfo.QuestName, difficulty.name, questStatus);
-                    }
-                }
-            }
-        }
+        // The quest data stays loaded between refreshes and is only read again once its files change
+        std::shared_ptr<const QuestDatabase> database = QuestDatabase::load(m_settings->getQuestsFilePath());
+
+        // Offer the languages of the quest data
+        updateLanguageComboBox(database->locales(), m_settings->getLocale());
+
+        // Resolve the statuses of every difficulty, and keep them for switching the language later
+        QVector<ResolvedStatus> statuses;
+        resolveQuestStatus(gddFilePath, *database, statuses);
+        m_questStatuses = statuses;
+
+        // Show them with the names in the selected language
+        applyQuestNames(m_questStatuses, *database, database->localeIndex(m_settings->getLocale()), questData);
 
         // Populate the table view with the updated quest data
         populateTableView(questData);
+        emit dataRefreshed();
     } catch (QException &) {
         qDebug() << "An error occurred during parsing.";
     }
 }
 
+void QuestTrackerWindow::updateQuestNames()
+{
+    TraceZone zone("QuestTrackerWindow::updateQuestNames");
+
+    try {
+        std::shared_ptr<const QuestDatabase> database = QuestDatabase::load(m_settings->getQuestsFilePath());
+
+        // Only the names change, so the statuses of the last refresh are reused without reading the saves
+        QuestData questData;
+        applyQuestNames(m_questStatuses, *database, database->localeIndex(m_settings->getLocale()), questData);
+        populateTableView(questData);
+    } catch (QException &) {
+        qDebug() << "An error occurred while loading the quest data.";
+    }
+}
+
+void QuestTrackerWindow::setAutoRefreshDelay(int ms)
+{
+    m_refreshTimer->setInterval(ms);
+}
+
+void QuestTrackerWindow::watchQuestFiles(const QString &levelsDirPath)
+{
+    QStringList directories;
+    QStringList files;
+    QHash<QString, QString> stamps;
+
+    for (const Difficulty &difficulty : Difficulty::getAllDifficulties()) {
+        QString difficultyDir = QDir::cleanPath(levelsDirPath + "/" + difficulty.name);
+        QString questsFile = difficultyDir + "/quests.gdd";
+
+        if (QFileInfo::exists(difficultyDir)) {
+            directories.append(difficultyDir);
+        }
+        if (QFileInfo::exists(questsFile)) {
+            files.append(questsFile);
+        }
+
+        // Remember the current version, so unrelated changes in the folder don't trigger refreshes
+        stamps.insert(questsFile, fileStamp(questsFile));
+    }
+
+    m_questFileStamps = stamps;
+
+    // Replace the watched paths only if they changed, e.g. for a different character
+    QStringList watchedDirectories = m_saveWatcher->directories();
+    QStringList watchedFiles = m_saveWatcher->files();
+
+    if (watchedDirectories != directories) {
+        if (!watchedDirectories.isEmpty()) m_saveWatcher->removePaths(watchedDirectories);
+        if (!directories.isEmpty()) m_saveWatcher->addPaths(directories);
+    }
+
+    // A file replaced on save is dropped from the watcher, so always re-add the current files
+    for (const QString &file : files) {
+        if (!watchedFiles.contains(file)) {
+            m_saveWatcher->addPath(file);
+        }
+    }
+}
+
+void QuestTrackerWindow::onSavePathChanged(const QString &path)
+{
+    // A folder notification covers every file in it; only react if a quests file actually changed
+    bool changed = false;
+    for (auto it = m_questFileStamps.cbegin(); it != m_questFileStamps.cend(); ++it) {
+        if ((it.key() == path || QFileInfo(it.key()).path() == path) && fileStamp(it.key()) != it.value()) {
+            changed = true;
+            break;
+        }
+    }
+
+    if (changed) {
+        qDebug() << "Quests file changed on disk:" << path;
+        m_refreshTimer->start();
+    }
+}
+
+QString QuestTrackerWindow::fileStamp(const QString &filePath)
+{
+    QFileInfo info(filePath);
+    if (!info.exists()) {
+        return QString();
+    }
+
+    // Size and modification time are enough to tell two saves apart
+    return QString("%1:%2").arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch());
+}
+
 void QuestTrackerWindow::initializeSettings()
 {
     // Load available themes and populate the theme combo box
@@ -196,6 +324,12 @@ void QuestTrackerWindow::initializeSettings()
 
     // Connect theme selection to settings for applying the chosen theme
     connect(ui->comboBoxTheme, &QComboBox::currentTextChanged, m_settings, &Settings::setTheme);
+
+    // Switching the language renames the quests of the last refresh; the saves are not read again
+    connect(ui->comboBoxLanguage, &QComboBox::currentIndexChanged, this, [this](int index) {
+        if (index >= 0)
+            m_settings->setLocale(ui->comboBoxLanguage->itemData(index).toString());
+    });
 }
 
 void QuestTrackerWindow::initializeLogging()
@@ -205,11 +339,119 @@ void QuestTrackerWindow::initializeLogging()
     qInstallMessageHandler(customMessageHandler);
 }
 
+void QuestTrackerWindow::initializeDiagnostics()
+{
+    ui->tableWidgetDiagnostics->setColumnCount(8);
+    ui->tableWidgetDiagnostics->setHorizontalHeaderLabels({"Operation", "Count", "Last (ms)", "Mean (ms)", "p95 (ms)", "Max (ms)", "MB/s", "Items"});
+    ui->tableWidgetDiagnostics->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    // Time the trace zones and poll the counters only while the tab is visible, so the other tabs
+    // pay nothing for them; an unchanged generation skips the redraw
+    m_diagnosticsTimer = new QTimer(this);
+    m_diagnosticsTimer->setInterval(500);
+    connect(m_diagnosticsTimer, &QTimer::timeout, this, &QuestTrackerWindow::updateDiagnostics);
+
+    auto showDiagnostics = [this](int index) {
+        const bool visible = ui->tabQestsTracker->widget(index) == ui->tab_3;
+        PerfCounters::setEnabled(visible);
+
+        if (visible) {
+            m_diagnosticsGeneration = 0;
+            updateDiagnostics();
+            m_diagnosticsTimer->start();
+        } else {
+            m_diagnosticsTimer->stop();
+        }
+    };
+    connect(ui->tabQestsTracker, &QTabWidget::currentChanged, this, showDiagnostics);
+    showDiagnostics(ui->tabQestsTracker->currentIndex());
+
+    connect(ui->buttonResetDiagnostics, &QPushButton::clicked, this, [this] {
+        PerfCounters::reset();
+        updateDiagnostics();
+    });
+}
+
+void QuestTrackerWindow::updateDiagnostics()
+{
+    quint64 generation = PerfCounters::generation();
+    if (generation == m_diagnosticsGeneration) {
+        return;
+    }
+    m_diagnosticsGeneration = generation;
+
+    auto ms = [](qint64 ns) { return QString::number(ns / 1e6, 'f', 2); };
+
+    // One row per operation, with timings over the most recent runs
+    const QVector<PerfCounters::ZoneStats> zones = PerfCounters::zones();
+    QTableWidget *table = ui->tableWidgetDiagnostics;
+    table->setRowCount(zones.size());
+
+    for (int row = 0; row < zones.size(); ++row) {
+        const PerfCounters::ZoneStats &zone = zones[row];
+        const QStringList cells = {
+            zone.name,
+            QString::number(zone.count),
+            ms(zone.lastNs),
+            ms(zone.meanNs),
+            ms(zone.p95Ns),
+            ms(zone.maxNs),
+            zone.megabytesPerSecond >= 0 ? QString::number(zone.megabytesPerSecond, 'f', 1) : QString(),
+            zone.lastItems >= 0 ? QString::number(zone.lastItems) : QString()
+        };
+
+        for (int column = 0; column < cells.size(); ++column) {
+            QTableWidgetItem *item = table->item(row, column);
+            if (!item) {
+                item = new QTableWidgetItem;
+                table->setItem(row, column, item);
+            }
+            item->setText(cells[column]);
+        }
+    }
+
+    // Lookup hit rates, gauges and memory below the table
+    QStringList lines;
+    for (const PerfCounters::RatioStats &lookup : PerfCounters::lookups()) {
+        quint64 total = lookup.hits + lookup.misses;
+        lines << QString("%1: %2% hits (%3 of %4)").arg(lookup.name).arg(total ? 100.0 * lookup.hits / total : 0.0, 0, 'f', 1).arg(lookup.hits).arg(total);
+    }
+    for (const PerfCounters::GaugeStats &gauge : PerfCounters::gauges()) {
+        lines << QString("%1: %2 (peak %3)").arg(gauge.name).arg(gauge.value).arg(gauge.peak);
+    }
+    lines << QString("Worker threads active: %1 of %2").arg(QThreadPool::globalInstance()->activeThreadCount()).arg(QThreadPool::globalInstance()->maxThreadCount());
+
+    if (AllocStats::isAvailable()) {
+        lines << QString("Heap: %1 allocations, %2 MiB live").arg(AllocStats::allocations.load()).arg(AllocStats::liveBytes.load() / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+    qint64 rss = AllocStats::currentRss();
+    if (rss >= 0) {
+        lines << QString("Resident memory: %1 MiB (peak %2 MiB)").arg(rss / (1024.0 * 1024.0), 0, 'f', 1).arg(AllocStats::peakRss() / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+
+    ui->labelDiagnosticsCounters->setText(lines.join('\n'));
+}
+
 void QuestTrackerWindow::customMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
 {
-    QMutex mutex;
-    QMutexLocker locker(&mutex);
+    Q_UNUSED(context);
+
+    if (type == QtFatalMsg)
+        abort();
+
+    if (textEditLogInstance) {
+        // Messages from worker threads (e.g. the QST parser) are handed to the GUI thread,
+        // which is also the only thread that may read the palette to pick the colors
+        QTextEdit *textEdit = textEditLogInstance;
+        QMetaObject::invokeMethod(textEdit, [textEdit, type, msg] {
+            textEdit->append(formatLogMessage(type, msg));
+            textEdit->ensureCursorVisible();
+        }, QThread::currentThread() == textEdit->thread() ? Qt::DirectConnection : Qt::QueuedConnection);
+    }
+}
 
+QString QuestTrackerWindow::formatLogMessage(QtMsgType type, const QString &msg)
+{
     // Determine the theme and appropriate color for log message based on message type
     Theme currentTheme = Theme::getThemeByName(qApp->palette().color(QPalette::Window).lightness() > 127 ? "Light Theme" : "Dark Theme");
 
@@ -234,19 +476,14 @@ void QuestTrackerWindow::customMessageHandler(QtMsgType type, const QMessageLogC
         break;
     case QtFatalMsg:
         color = currentTheme.fatalColor;
-        abort();
+        break;
     case QtInfoMsg:
         color = currentTheme.infoColor;
         break;
     }
 
     // Format the message with HTML color styling for display in the log
-    QString formattedMessage = QString("<span style=\"color:%1;\">%2</span>").arg(color, message.toHtmlEscaped());
-
-    if (textEditLogInstance) {
-        textEditLogInstance->append(formattedMessage);
-        textEditLogInstance->ensureCursorVisible();
-    }
+    return QString("<span style=\"color:%1;\">%2</span>").arg(color, message.toHtmlEscaped());
 }
 
 void QuestTrackerWindow::updateSaveDirPath(const QString &path)
@@ -291,8 +528,27 @@ void QuestTrackerWindow::updateQstFilesDirPath(const QString &path)
     ui->lineEditQstFilesPath->setText(path);
 }
 
+void QuestTrackerWindow::updateLanguageComboBox(const QStringList &locales, const QString &selectedLocale)
+{
+    // Temporarily block signals to avoid triggering a refresh while the list is rebuilt
+    bool oldState = ui->comboBoxLanguage->blockSignals(true);
+    ui->comboBoxLanguage->clear();
+
+    for (const QString &locale : locales) {
+        // "deDE" is shown as "Deutsch (deDE)"
+        QString languageName = QLocale(locale.left(2) + "_" + locale.mid(2)).nativeLanguageName();
+        ui->comboBoxLanguage->addItem(languageName.isEmpty() ? locale : QString("%1 (%2)").arg(languageName, locale), locale);
+    }
+
+    int index = ui->comboBoxLanguage->findData(selectedLocale);
+    ui->comboBoxLanguage->setCurrentIndex(index >= 0 ? index : ui->comboBoxLanguage->findData("enUS"));
+    ui->comboBoxLanguage->blockSignals(oldState);
+}
+
 void QuestTrackerWindow::updateTheme(const QString &themeName)
 {
+    TraceZone zone("QuestTrackerWindow::updateTheme");
+
     // Temporarily block signals to avoid triggering extra events during theme change
     bool oldState = ui->comboBoxTheme->blockSignals(true);
     int index = ui->comboBoxTheme->findText(themeName);
@@ -4,10 +4,14 @@
 #include <QMainWindow>
 #include <QTextEdit>
 #include <QSortFilterProxyModel>
+#include <QHash>
 #include "types.h"
+#include "quest_status.h"
 
 // Forward declaration
 class Settings;
+class QFileSystemWatcher;
+class QTimer;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -58,9 +62,28 @@ public:
      * @brief Refreshes quest data based on the current character and difficulty settings.
      *
      * This method updates the displayed quest data by reading the current settings and files.
+     * The character's quests files are then watched, so the table refreshes itself whenever
+     * the game saves them.
      */
     void refreshData();
 
+    /**
+     * @brief Shows the quest table in the language selected in the settings.
+     *
+     * Reuses the statuses resolved by the last refreshData, so the quests files are not read again.
+     */
+    void updateQuestNames();
+
+    /**
+     * @brief Sets how long to wait after a quests file changes before refreshing.
+     *
+     * The game may write a file in several steps; changes arriving within the delay are
+     * merged into a single refresh.
+     *
+     * @param ms The delay in milliseconds.
+     */
+    void setAutoRefreshDelay(int ms);
+
     /**
      * @brief Generates a JSON file containing quest data.
      *
@@ -129,6 +152,16 @@ public:
      */
     void updateTheme(const QString &theme);
 
+    /**
+     * @brief Updates the language selection combo box.
+     *
+     * Lists the languages of the loaded quest data by their native names.
+     *
+     * @param locales Locale tags of the available languages (e.g. "enUS", "deDE").
+     * @param selectedLocale The locale to set as currently selected.
+     */
+    void updateLanguageComboBox(const QStringList &locales, const QString &selectedLocale);
+
     // Static Methods
 
     /**
@@ -143,6 +176,12 @@ public:
      */
     static void customMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg);
 
+signals:
+    /**
+     * @brief Emitted after refreshData has rebuilt the quest table.
+     */
+    void dataRefreshed();
+
 private:
     // Initialization Methods
 
@@ -160,11 +199,58 @@ private:
      */
     void initializeLogging();
 
+    /**
+     * @brief Sets up the Diagnostics tab, which feeds trace zones into the performance counters while it is visible.
+     */
+    void initializeDiagnostics();
+
+    /**
+     * @brief Redraws the Diagnostics tab from the performance counters if anything changed.
+     */
+    void updateDiagnostics();
+
+    // Live Tracking
+
+    /**
+     * @brief Watches the quests files of a character for changes made by the game.
+     *
+     * Watches the difficulty folders as well as the files, because saving by replacing a file
+     * ends the watch on the old one.
+     *
+     * @param levelsDirPath Path to the character's levels_world001.map folder.
+     */
+    void watchQuestFiles(const QString &levelsDirPath);
+
+    /**
+     * @brief Schedules a refresh if a watched quests file was modified.
+     *
+     * @param path The changed file or folder reported by the watcher.
+     */
+    void onSavePathChanged(const QString &path);
+
+    /**
+     * @brief Returns a stamp that changes whenever the file is rewritten.
+     */
+    static QString fileStamp(const QString &filePath);
+
+    /**
+     * @brief Formats a log message as HTML, colored for its type and the current theme.
+     *
+     * Reads the application palette, so it must run on the GUI thread.
+     */
+    static QString formatLogMessage(QtMsgType type, const QString &msg);
+
     // Member Variables
     Ui::QuestTrackerWindow *ui;                ///< The UI form class generated by Qt Designer.
     QSortFilterProxyModel *proxyModel;         ///< Model for filtering quest table data.
     QStringList m_originalCharacterNames;      ///< List of original character names for selection.
     Settings *m_settings;                      ///< Pointer to the settings manager.
+    QFileSystemWatcher *m_saveWatcher;         ///< Watches the current character's quests files.
+    QTimer *m_refreshTimer;                    ///< Delays refreshes until the game has finished saving.
+    QHash<QString, QString> m_questFileStamps; ///< Last seen stamp of each watched quests file.
+    QVector<ResolvedStatus> m_questStatuses;   ///< Statuses of the last refresh, by quest hash.
+    QTimer *m_diagnosticsTimer;                ///< Refreshes the Diagnostics tab while it is visible.
+    quint64 m_diagnosticsGeneration = 0;       ///< Counter generation shown on the Diagnostics tab.
 
     // Static Members
     static QTextEdit *textEditLogInstance;     ///< Static instance of log text edit for displaying logs.
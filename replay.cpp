@@ -0,0 +1,539 @@
+#include "gdd_generator.h"
+#include "gdd_writer.h"
+#include "questtrackerwindow.h"
+
+#include <QAbstractItemModel>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTableView>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#if defined(Q_OS_WIN)
+#  define NOMINMAX
+#  include <windows.h>
+#else
+#  include <sys/resource.h>
+#endif
+
+namespace
+{
+    const char *const characterName = "_Replay";
+
+    /**
+     * @brief One quests.gdd version of a replayed sequence.
+     */
+    struct ReplayStep
+    {
+        /// Time of the write, in milliseconds after the sequence starts.
+        qint64 offsetMs = 0;
+        /// Difficulty folder the file belongs to.
+        QString difficulty;
+        /// Raw file contents.
+        QByteArray contents;
+        /// Quest whose row must show @ref expectedStatus once the update is visible; empty if unknown.
+        QString expectedQuest;
+        /// Status text expected in the difficulty column of @ref expectedQuest.
+        QString expectedStatus;
+    };
+
+    /**
+     * @brief Measurement of one replayed step.
+     */
+    struct StepResult
+    {
+        qint64 latencyUs = -1;   // Write to painted table, -1 on timeout
+        qint64 cpuUs = 0;        // Process CPU time spent until then
+        int refreshes = 0;       // Number of table rebuilds it took
+    };
+
+    // Process CPU time (user + system) in microseconds
+    qint64 processCpuUs()
+    {
+#if defined(Q_OS_WIN)
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+            return 0;
+
+        auto toUs = [](const FILETIME &t) { return ((qint64(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 10; };
+        return toUs(kernel) + toUs(user);
+#else
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return qint64(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+    }
+
+    bool writeFile(const QString &path, const QByteArray &bytes)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(bytes) == bytes.size();
+    }
+
+    // Writes a save the way the game might: either in place or by atomically replacing the file
+    bool writeSave(const QString &path, const QByteArray &bytes, bool inPlace)
+    {
+        if (inPlace)
+            return writeFile(path, bytes);
+
+        QSaveFile file(path);
+        return file.open(QIODevice::WriteOnly) && file.write(bytes) == bytes.size() && file.commit();
+    }
+
+    QString questName(int index)
+    {
+        return QString("Replay Quest %1").arg(index, 4, 10, QChar('0'));
+    }
+
+    /**
+     * @brief Builds a synthetic sequence in which every step completes or resets one quest.
+     *
+     * Writes the matching quests.json catalog to @p catalogPath and returns the initial file in
+     * @p initial.
+     */
+    QVector<ReplayStep> makeSyntheticSequence(int steps, int questCount, qint64 intervalMs, const QString &catalogPath, QByteArray &initial)
+    {
+        SyntheticSaveOptions options;
+        options.seed = 7;
+        options.quests = quint32(questCount);
+        options.tasksPerQuest = 4;
+        options.objectivesPerTask = 2;
+
+        // Catalog entries for every quest id in the file, so each quest has a row in the table
+        QJsonObject catalog;
+        for (int i = 0; i < questCount; i++) {
+            quint32 id = 0x10000000u + quint32(i) * 7919u;
+            options.questIds.append(id);
+
+            QJsonObject quest;
+            quest["Chapter"] = QString("Replay Chapter %1").arg(i % 20);
+            quest["QuestName"] = questName(i);
+            catalog[QString("0x%1").arg(id, 8, 16, QChar('0'))] = quest;
+        }
+        writeFile(catalogPath, QJsonDocument(catalog).toJson());
+
+        QuestsFile file;
+        GddGenerator::generate(options, file);
+
+        // Start with every task untouched
+        for (Quest &quest : file.quests.quests) {
+            for (Task &task : quest.tasks) {
+                task.state = 0;
+                task.inProgress = 0;
+            }
+        }
+
+        QuestsFileWriter writer;
+        initial = writer.encode(file);
+
+        // Each step flips one quest; after a full pass, quests are reset again
+        QVector<ReplayStep> sequence;
+        for (int step = 0; step < steps; step++) {
+            int index = step % questCount;
+            bool complete = (step / questCount) % 2 == 0;
+
+            for (Task &task : file.quests.quests[index].tasks)
+                task.state = complete ? 3 : 0;
+
+            ReplayStep replayStep;
+            replayStep.offsetMs = qint64(step + 1) * intervalMs;
+            replayStep.difficulty = "Normal";
+            replayStep.contents = writer.encode(file);
+            replayStep.expectedQuest = questName(index);
+            replayStep.expectedStatus = QuestStatus(complete ? QuestStatus::Completed : QuestStatus::NotCompleted).toString();
+            sequence.append(replayStep);
+        }
+
+        return sequence;
+    }
+
+    /**
+     * @brief Loads a sequence recorded with --record.
+     *
+     * The first version of each difficulty becomes the initial state; the others are replayed.
+     */
+    QVector<ReplayStep> loadRecording(const QString &dir, QMap<QString, QByteArray> &initial)
+    {
+        QVector<ReplayStep> sequence;
+
+        QFile manifestFile(QDir(dir).filePath("manifest.json"));
+        if (!manifestFile.open(QIODevice::ReadOnly))
+            return sequence;
+
+        const QJsonArray entries = QJsonDocument::fromJson(manifestFile.readAll()).object().value("versions").toArray();
+        qint64 firstOffset = -1;
+
+        for (const QJsonValue &value : entries) {
+            QJsonObject entry = value.toObject();
+
+            QFile version(QDir(dir).filePath(entry.value("file").toString()));
+            if (!version.open(QIODevice::ReadOnly))
+                continue;
+
+            QString difficulty = entry.value("difficulty").toString();
+            QByteArray contents = version.readAll();
+
+            if (!initial.contains(difficulty)) {
+                initial.insert(difficulty, contents);
+                continue;
+            }
+
+            ReplayStep step;
+            step.offsetMs = qint64(entry.value("offset_ms").toDouble());
+            step.difficulty = difficulty;
+            step.contents = contents;
+
+            if (firstOffset < 0)
+                firstOffset = step.offsetMs;
+            step.offsetMs -= firstOffset;
+
+            sequence.append(step);
+        }
+
+        return sequence;
+    }
+
+    /**
+     * @brief Records every new version of a character's quests files into a directory.
+     */
+    int record(const QString &levelsDir, const QString &outDir, int durationSec)
+    {
+        QTextStream out(stdout);
+        QDir().mkpath(outDir);
+
+        QElapsedTimer clock;
+        clock.start();
+
+        QJsonArray versions;
+        QMap<QString, QByteArray> lastContents;
+        QFileSystemWatcher watcher;
+
+        // Copies the file if its contents differ from the last recorded version
+        auto capture = [&](const QString &difficulty) {
+            QString path = QString("%1/%2/quests.gdd").arg(levelsDir, difficulty);
+
+            QFile file(path);
+            if (!file.open(QIODevice::ReadOnly))
+                return;
+
+            QByteArray contents = file.readAll();
+            if (contents.isEmpty() || lastContents.value(difficulty) == contents)
+                return;
+            lastContents.insert(difficulty, contents);
+
+            QString name = QString("%1_%2.gdd").arg(versions.size(), 4, 10, QChar('0')).arg(difficulty);
+            writeFile(QDir(outDir).filePath(name), contents);
+
+            QJsonObject entry;
+            entry["file"] = name;
+            entry["difficulty"] = difficulty;
+            entry["offset_ms"] = clock.elapsed();
+            versions.append(entry);
+
+            out << "Recorded " << name << " at " << clock.elapsed() << " ms" << Qt::endl;
+        };
+
+        for (const Difficulty &difficulty : Difficulty::getAllDifficulties()) {
+            watcher.addPath(QString("%1/%2").arg(levelsDir, difficulty.name));
+            capture(difficulty.name);
+        }
+
+        QObject::connect(&watcher, &QFileSystemWatcher::directoryChanged, [&](const QString &path) {
+            capture(QFileInfo(path).fileName());
+        });
+
+        out << "Recording " << levelsDir << " for " << durationSec << " s; play the game now." << Qt::endl;
+
+        QTimer::singleShot(durationSec * 1000, qApp, &QCoreApplication::quit);
+        qApp->exec();
+
+        QJsonObject manifest;
+        manifest["versions"] = versions;
+        writeFile(QDir(outDir).filePath("manifest.json"), QJsonDocument(manifest).toJson());
+
+        out << "Recorded " << versions.size() << " versions to " << outDir << Qt::endl;
+        return versions.isEmpty() ? 1 : 0;
+    }
+
+    /**
+     * @brief Detects when the quest table has been repainted after a refresh.
+     */
+    class PaintProbe : public QObject
+    {
+    public:
+        explicit PaintProbe(QWidget *viewport) : m_viewport(viewport) { viewport->installEventFilter(this); }
+
+        /// Set after every refresh; the next paint completes the update.
+        bool refreshed = false;
+        /// Called once the refreshed table has been painted.
+        std::function<void()> onPainted;
+
+    protected:
+        bool eventFilter(QObject *watched, QEvent *event) override
+        {
+            if (watched == m_viewport && event->type() == QEvent::Paint && refreshed) {
+                refreshed = false;
+
+                // Stamp the time once the paint event has been fully handled
+                QTimer::singleShot(0, this, [this] {
+                    if (onPainted)
+                        onPainted();
+                });
+            }
+            return false;
+        }
+
+    private:
+        QWidget *m_viewport;
+    };
+
+    // Checks whether the table shows the expected status for a quest
+    bool tableShows(QAbstractItemModel *model, const QString &quest, int column, const QString &status)
+    {
+        for (int row = 0; row < model->rowCount(); row++) {
+            if (model->index(row, 1).data().toString() == quest)
+                return model->index(row, column).data().toString() == status;
+        }
+        return false;
+    }
+
+    qint64 percentile(QVector<qint64> values, double p)
+    {
+        if (values.isEmpty())
+            return -1;
+
+        std::sort(values.begin(), values.end());
+        int index = qBound(0, int(std::ceil(p * values.size())) - 1, int(values.size()) - 1);
+        return values[index];
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Drive the real window without a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gdqt_replay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays quests.gdd versions into a temporary save folder and measures the save-to-screen latency of GDQT.");
+    parser.addHelpOption();
+
+    QCommandLineOption stepsOption("steps", "Number of synthetic updates.", "n", "50");
+    QCommandLineOption questsOption("quests", "Number of quests in the synthetic save.", "n", "400");
+    QCommandLineOption intervalOption("interval", "Milliseconds between synthetic updates.", "ms", "300");
+    QCommandLineOption recordingOption("recording", "Replay a sequence recorded with --record instead of a synthetic one.", "dir");
+    QCommandLineOption catalogOption("catalog", "quests.json used with --recording.", "path");
+    QCommandLineOption recordOption("record", "Record the quests files of a real character folder (levels_world001.map) into --out.", "dir");
+    QCommandLineOption durationOption("duration", "Recording length in seconds.", "s", "600");
+    QCommandLineOption delayOption("refresh-delay", "Auto-refresh delay of the window in milliseconds.", "ms");
+    QCommandLineOption inPlaceOption("in-place", "Overwrite quests.gdd in place instead of replacing it atomically.");
+    QCommandLineOption timeoutOption("timeout", "Milliseconds to wait for an update to show before giving up.", "ms", "5000");
+    QCommandLineOption outOption("out", "Results JSON file, or the recording directory with --record.", "path");
+    parser.addOptions({stepsOption, questsOption, intervalOption, recordingOption, catalogOption, recordOption,
+                       durationOption, delayOption, inPlaceOption, timeoutOption, outOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+
+    if (parser.isSet(recordOption)) {
+        if (!parser.isSet(outOption)) {
+            out << "--record needs --out <dir>" << Qt::endl;
+            return 1;
+        }
+        return record(parser.value(recordOption), parser.value(outOption), parser.value(durationOption).toInt());
+    }
+
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        out << "Could not create a temporary directory" << Qt::endl;
+        return 1;
+    }
+
+    // Results are written relative to the caller's directory, everything else goes to the sandbox
+    QString resultsPath = parser.isSet(outOption) ? QFileInfo(parser.value(outOption)).absoluteFilePath() : QString();
+    QDir::setCurrent(workDir.path());
+
+    // Fake save folder with one character and all difficulties
+    QString levelsDir = workDir.filePath(QString("saves/%1/levels_world001.map").arg(characterName));
+    for (const Difficulty &difficulty : Difficulty::getAllDifficulties())
+        QDir().mkpath(levelsDir + "/" + difficulty.name);
+
+    QString catalogPath = workDir.filePath("quests.json");
+    QVector<ReplayStep> sequence;
+
+    if (parser.isSet(recordingOption)) {
+        QMap<QString, QByteArray> initial;
+        sequence = loadRecording(parser.value(recordingOption), initial);
+
+        for (auto it = initial.cbegin(); it != initial.cend(); ++it)
+            writeFile(QString("%1/%2/quests.gdd").arg(levelsDir, it.key()), it.value());
+
+        if (!parser.isSet(catalogOption) || !QFile::copy(parser.value(catalogOption), catalogPath)) {
+            out << "--recording needs --catalog <quests.json>" << Qt::endl;
+            return 1;
+        }
+    } else {
+        QByteArray initial;
+        sequence = makeSyntheticSequence(parser.value(stepsOption).toInt(), qMax(1, parser.value(questsOption).toInt()),
+                                         parser.value(intervalOption).toLongLong(), catalogPath, initial);
+        writeFile(levelsDir + "/Normal/quests.gdd", initial);
+    }
+
+    if (sequence.isEmpty()) {
+        out << "Nothing to replay" << Qt::endl;
+        return 1;
+    }
+
+    // Point the application at the fake save folder through its regular settings file
+    QJsonObject settings;
+    settings["saveDirPath"] = workDir.filePath("saves");
+    settings["questsFilePath"] = catalogPath;
+    settings["characterName"] = characterName;
+    writeFile("Settings.json", QJsonDocument(settings).toJson());
+
+    QuestTrackerWindow window;
+    if (parser.isSet(delayOption))
+        window.setAutoRefreshDelay(parser.value(delayOption).toInt());
+
+    QTableView *table = window.findChild<QTableView *>("tableViewQuestsList");
+    if (!table) {
+        out << "Quest table not found" << Qt::endl;
+        return 1;
+    }
+
+    PaintProbe probe(table->viewport());
+    int refreshes = 0;
+    QObject::connect(&window, &QuestTrackerWindow::dataRefreshed, [&] {
+        refreshes++;
+        probe.refreshed = true;
+    });
+
+    window.refreshData();
+    window.show();
+    QThread::msleep(50);
+    app.processEvents();
+
+    const bool inPlace = parser.isSet(inPlaceOption);
+    const int timeoutMs = parser.value(timeoutOption).toInt();
+    const QStringList difficultyColumns = {"Normal", "Elite", "Ultimate"};
+
+    QVector<StepResult> results;
+    QElapsedTimer clock;
+    clock.start();
+
+    for (const ReplayStep &step : sequence) {
+        // Keep to the recorded schedule while the application stays idle
+        while (clock.elapsed() < step.offsetMs) {
+            app.processEvents(QEventLoop::AllEvents, int(step.offsetMs - clock.elapsed()));
+            QThread::msleep(1);
+        }
+
+        StepResult result;
+        QEventLoop loop;
+        QElapsedTimer latency;
+        int column = 2 + difficultyColumns.indexOf(step.difficulty);
+
+        probe.refreshed = false;
+        probe.onPainted = [&] {
+            // A refresh that raced with the write may still show the old state; wait for the next one
+            if (!step.expectedQuest.isEmpty() && !tableShows(table->model(), step.expectedQuest, column, step.expectedStatus))
+                return;
+
+            result.latencyUs = latency.nsecsElapsed() / 1000;
+            loop.quit();
+        };
+
+        int refreshesBefore = refreshes;
+        qint64 cpuBefore = processCpuUs();
+
+        if (!writeSave(QString("%1/%2/quests.gdd").arg(levelsDir, step.difficulty), step.contents, inPlace)) {
+            out << "Failed to write step " << results.size() << Qt::endl;
+            return 1;
+        }
+        latency.start();
+
+        QTimer::singleShot(timeoutMs, &loop, &QEventLoop::quit);
+        if (result.latencyUs < 0)
+            loop.exec();
+
+        result.cpuUs = processCpuUs() - cpuBefore;
+        result.refreshes = refreshes - refreshesBefore;
+        probe.onPainted = nullptr;
+        results.append(result);
+
+        if (result.latencyUs < 0)
+            out << QString("step %1: no update within %2 ms").arg(results.size()).arg(timeoutMs) << Qt::endl;
+    }
+
+    // Summarize
+    QVector<qint64> latencies;
+    qint64 cpuTotal = 0;
+    int timeouts = 0;
+    for (const StepResult &result : results) {
+        if (result.latencyUs < 0) {
+            timeouts++;
+            continue;
+        }
+        latencies.append(result.latencyUs);
+        cpuTotal += result.cpuUs;
+    }
+
+    qint64 p50 = percentile(latencies, 0.50);
+    qint64 p99 = percentile(latencies, 0.99);
+    qint64 worst = percentile(latencies, 1.0);
+    qint64 cpuMean = latencies.isEmpty() ? 0 : cpuTotal / latencies.size();
+
+    out << QString("%1 updates, %2 timed out").arg(results.size()).arg(timeouts) << Qt::endl;
+    out << QString("save-to-screen latency: p50 %1 ms, p99 %2 ms, max %3 ms")
+               .arg(p50 / 1000.0, 0, 'f', 1)
+               .arg(p99 / 1000.0, 0, 'f', 1)
+               .arg(worst / 1000.0, 0, 'f', 1)
+        << Qt::endl;
+    out << QString("CPU time per update: %1 ms").arg(cpuMean / 1000.0, 0, 'f', 1) << Qt::endl;
+
+    if (!resultsPath.isEmpty()) {
+        QJsonArray steps;
+        for (const StepResult &result : results) {
+            QJsonObject step;
+            step["latency_us"] = result.latencyUs;
+            step["cpu_us"] = result.cpuUs;
+            step["refreshes"] = result.refreshes;
+            steps.append(step);
+        }
+
+        QJsonObject root;
+        root["updates"] = int(results.size());
+        root["timeouts"] = timeouts;
+        root["p50_us"] = p50;
+        root["p99_us"] = p99;
+        root["max_us"] = worst;
+        root["cpu_per_update_us"] = cpuMean;
+        root["steps"] = steps;
+
+        if (!writeFile(resultsPath, QJsonDocument(root).toJson())) {
+            out << "Could not write " << resultsPath << Qt::endl;
+            return 1;
+        }
+    }
+
+    return timeouts == 0 ? 0 : 2;
+}
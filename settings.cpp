@@ -1,5 +1,8 @@
 #include "settings.h"
 #include "questtrackerwindow.h"
+#include "trace.h"
+#include "quest_status.h"
+#include "quest_database.h"
 #include <QFileDialog>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -17,6 +20,8 @@ Settings::Settings(QuestTrackerWindow *window, const QString &settingsFilePath)
 
 bool Settings::load()
 {
+    TraceZone zone("Settings::load");
+
     QFile file(m_settingsFilePath);
 
     // Try to open the settings file for reading
@@ -29,9 +34,11 @@ bool Settings::load()
         m_qstFilesDirPath.clear();
         m_characterName.clear();
         m_theme = Theme::availableThemeNames().first(); // Set to default theme
+        m_locale = "enUS";
     } else {
         QByteArray data = file.readAll();
         file.close();
+        zone.setBytes(data.size());
 
         // Parse JSON from the file and validate format
         QJsonDocument doc = QJsonDocument::fromJson(data);
@@ -44,6 +51,7 @@ bool Settings::load()
             m_qstFilesDirPath.clear();
             m_characterName.clear();
             m_theme = Theme::availableThemeNames().first(); // Default theme
+            m_locale = "enUS";
         } else {
             QJsonObject obj = doc.object();
 
@@ -53,6 +61,7 @@ bool Settings::load()
             m_qstFilesDirPath = obj.value("qstFilesDirPath").toString();
             m_characterName = obj.value("characterName").toString();
             m_theme = obj.value("theme").toString();
+            m_locale = obj.value("locale").toString("enUS");
 
             // Validate theme against available themes
             if (!Theme::availableThemeNames().contains(m_theme)) {
@@ -71,7 +80,10 @@ bool Settings::load()
     m_window->updateSaveDirPath(m_saveDirPath);
     m_window->updateQuestsFilePath(m_questsFilePath);
     m_window->updateQstFilesDirPath(m_qstFilesDirPath);
-    m_window->updateCharacterComboBox(getAvailableCharacters(), m_characterName);
+    QStringList characters = getAvailableCharacters();
+    zone.setItems(characters.size());
+
+    m_window->updateCharacterComboBox(characters, m_characterName);
     m_window->updateTheme(m_theme);
 
     return true;
@@ -93,6 +105,7 @@ bool Settings::save() const
     obj["qstFilesDirPath"] = m_qstFilesDirPath;
     obj["characterName"] = m_characterName;
     obj["theme"] = m_theme;
+    obj["locale"] = m_locale;
 
     QJsonDocument doc(obj);
     file.write(doc.toJson(QJsonDocument::Indented));
@@ -145,6 +158,17 @@ void Settings::setTheme(const QString &theme)
     }
 }
 
+void Settings::setLocale(const QString &locale)
+{
+    // Store the display language and show the quest names in it
+    if (locale == m_locale)
+        return;
+
+    m_locale = locale;
+    save();
+    m_window->updateQuestNames();
+}
+
 QString Settings::getSaveDirPath() const
 {
     return m_saveDirPath;
@@ -165,26 +189,14 @@ QString Settings::getTheme() const
     return m_theme;
 }
 
-QStringList Settings::getAvailableCharacters() const
+QString Settings::getLocale() const
 {
-    QStringList characterList;
-    QDir saveDir(m_saveDirPath);
-
-    // List available characters by checking subdirectories for expected structure
-    if (saveDir.exists()) {
-        const QStringList subDirs = saveDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-
-        for (const QString &dir : subDirs) {
-            QDir characterDir(saveDir.filePath(dir + "/levels_world001.map"));
-
-            // Append character to list if any difficulty folder exists
-            if (characterDir.exists("Normal") || characterDir.exists("Elite") || characterDir.exists("Ultimate")) {
-                characterList.append(dir);
-            }
-        }
-    }
+    return m_locale;
+}
 
-    return characterList;
+QStringList Settings::getAvailableCharacters() const
+{
+    return findCharacters(m_saveDirPath);
 }
 
 void Settings::checkAndSetDefaultQuestsFilePath()
@@ -197,8 +209,11 @@ void Settings::checkAndSetDefaultQuestsFilePath()
         setQuestsFilePath(defaultQuestsFilePath);
         qDebug() << "Default quests.json file found and set:" << defaultQuestsFilePath;
     } else {
-        qWarning() << "The quests.json file is missing in the resources directory. "
-                      "Please specify the file path or generate a new file.";
+        if (QuestDatabase::hasBuiltIn())
+            qDebug() << "No quests.json in the resources directory, using the built-in quest database.";
+        else
+            qWarning() << "The quests.json file is missing in the resources directory. "
+                          "Please specify the file path or generate a new file.";
 
         // Clear the quests file path in the UI if default is not found
         m_questsFilePath = "";
@@ -54,12 +54,14 @@ public:
     void setQstFilesDirPath(const QString &path);
     void setCharacterName(const QString &name);
     void setTheme(const QString &theme);
+    void setLocale(const QString &locale);
 
     // Getters for retrieving current settings
     QString getSaveDirPath() const;
     QString getQuestsFilePath() const;
     QString getQstFilesDirPath() const;
     QString getTheme() const;
+    QString getLocale() const;
 
     /**
      * @brief Retrieves a list of available characters from the save directory.
@@ -106,6 +108,7 @@ private:
     QString m_qstFilesDirPath;       ///< Directory path where QST files are stored.
     QString m_characterName;         ///< Selected character name for quest tracking.
     QString m_theme;                 ///< Currently selected theme name.
+    QString m_locale;                ///< Locale tag of the language of quest names (e.g. "enUS").
     QuestTrackerWindow *m_window;    ///< Pointer to the main application window for UI updates.
 };
 
@@ -0,0 +1,173 @@
+#include "stall_watchdog.h"
+#include "trace.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+namespace
+{
+    // Upper bounds of the histogram buckets in milliseconds; the last bucket is open-ended
+    const qint64 bucketLimits[] = {33, 50, 100, 250, 500, 1000, 2000};
+    const int bucketCount = int(sizeof(bucketLimits) / sizeof(bucketLimits[0])) + 1;
+}
+
+StallWatchdog::StallWatchdog(int thresholdMs, QObject *parent)
+    : QObject(parent)
+    , m_thresholdMs(qMax(1, thresholdMs))
+    , m_thread(this)
+{
+}
+
+StallWatchdog::~StallWatchdog()
+{
+    stop();
+}
+
+void StallWatchdog::start()
+{
+    if (m_thread.isRunning())
+        return;
+
+    // Let the helper see which zone the main thread is in
+    Trace::setMainThreadTracking(true);
+
+    m_clock.start();
+    m_stopping = false;
+    m_thread.start(QThread::LowPriority);
+}
+
+void StallWatchdog::stop()
+{
+    if (!m_thread.isRunning())
+        return;
+
+    m_stopping = true;
+    m_thread.wait();
+
+    Trace::setMainThreadTracking(false);
+}
+
+int StallWatchdog::thresholdMs() const
+{
+    return m_thresholdMs;
+}
+
+QVector<StallRecord> StallWatchdog::stalls() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stalls;
+}
+
+void StallWatchdog::PingThread::run()
+{
+    StallWatchdog *w = m_watchdog;
+    const qint64 thresholdNs = qint64(w->m_thresholdMs) * 1000000;
+
+    // Poll a few times per threshold so the active zone is sampled early in a stall
+    const unsigned long pollMs = qBound(1, w->m_thresholdMs / 4, 25);
+
+    while (!w->m_stopping) {
+        quint64 sequence = w->m_sentSequence + 1;
+        w->m_sentAtNs = w->m_clock.nsecsElapsed();
+        w->m_sentSequence = sequence;
+
+        QMetaObject::invokeMethod(w, [w, sequence] { w->handlePing(sequence); }, Qt::QueuedConnection);
+
+        // Wait for the main thread to handle the ping, sampling its zone while it is late
+        while (!w->m_stopping && w->m_handledSequence < sequence) {
+            QThread::msleep(pollMs);
+
+            if (w->m_clock.nsecsElapsed() - w->m_sentAtNs > thresholdNs) {
+                const char *zone = Trace::activeZone.load(std::memory_order_relaxed);
+                QString name = zone ? QString::fromLatin1(zone) : QString("(no trace zone)");
+
+                QMutexLocker locker(&w->m_mutex);
+                if (w->m_currentZones.isEmpty() || w->m_currentZones.last() != name)
+                    w->m_currentZones.append(name);
+            }
+        }
+
+        // Idle between pings; there is no need to measure below the threshold
+        QThread::msleep(pollMs);
+    }
+}
+
+void StallWatchdog::handlePing(quint64 sequence)
+{
+    qint64 nowNs = m_clock.nsecsElapsed();
+    qint64 delayNs = nowNs - m_sentAtNs;
+
+    StallRecord record;
+    bool stalled = delayNs > qint64(m_thresholdMs) * 1000000;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (stalled) {
+            record.startMs = (nowNs - delayNs) / 1000000;
+            record.durationMs = delayNs / 1000000;
+            record.zones = m_currentZones;
+            if (record.zones.isEmpty())
+                record.zones.append("(no trace zone)");
+            m_stalls.append(record);
+        }
+
+        m_currentZones.clear();
+    }
+
+    m_handledSequence = sequence;
+
+    if (stalled) {
+        // Show the stall next to the zones that caused it in the trace and the performance counters
+        if (Trace::mode.load(std::memory_order_relaxed) & (Trace::Recording | Trace::Counting))
+            Trace::record("GUI stall", Trace::now() - delayNs, delayNs, -1, -1);
+
+        qWarning().noquote() << QString("GUI stalled for %1 ms in %2").arg(record.durationMs).arg(record.zones.join(" > "));
+    }
+}
+
+QString StallWatchdog::summary() const
+{
+    const QVector<StallRecord> records = stalls();
+
+    if (records.isEmpty())
+        return QString("No GUI stalls over %1 ms.").arg(m_thresholdMs);
+
+    qint64 total = 0;
+    const StallRecord *worst = &records.first();
+    int buckets[bucketCount] = {};
+
+    for (const StallRecord &record : records) {
+        total += record.durationMs;
+        if (record.durationMs > worst->durationMs)
+            worst = &record;
+
+        int bucket = int(std::upper_bound(std::begin(bucketLimits), std::end(bucketLimits), record.durationMs - 1) - std::begin(bucketLimits));
+        buckets[bucket]++;
+    }
+
+    QStringList lines;
+    lines << QString("GUI stalls over %1 ms: %2, %3 ms in total, worst %4 ms in %5")
+                 .arg(m_thresholdMs)
+                 .arg(records.size())
+                 .arg(total)
+                 .arg(worst->durationMs)
+                 .arg(worst->zones.join(" > "));
+
+    int largest = *std::max_element(std::begin(buckets), std::end(buckets));
+
+    for (int i = 0; i < bucketCount; i++) {
+        qint64 low = i == 0 ? m_thresholdMs : qMax<qint64>(m_thresholdMs, bucketLimits[i - 1]);
+        QString range = i < bucketCount - 1 ? QString("%1-%2 ms").arg(low).arg(bucketLimits[i]) : QString(">%1 ms").arg(low);
+
+        // Skip buckets entirely below the threshold
+        if (i < bucketCount - 1 && bucketLimits[i] <= m_thresholdMs)
+            continue;
+
+        int bar = largest > 0 ? (buckets[i] * 40 + largest - 1) / largest : 0;
+        lines << QString("  %1 |%2 %3").arg(range, -12).arg(QString(bar, '#'), -40).arg(buckets[i]);
+    }
+
+    return lines.join('\n');
+}
@@ -0,0 +1,111 @@
+#ifndef STALL_WATCHDOG_H
+#define STALL_WATCHDOG_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+
+#include <atomic>
+
+/**
+ * @brief One period during which the main event loop did not process events.
+ */
+struct StallRecord
+{
+    /// Milliseconds since the watchdog started at which the stall began.
+    qint64 startMs = 0;
+    /// Duration of the stall in milliseconds.
+    qint64 durationMs = 0;
+    /// Trace zones seen on the main thread while it was stalled, outermost first.
+    QStringList zones;
+};
+
+/**
+ * @class StallWatchdog
+ * @brief Detects stalls of the GUI event loop and reports where they happened.
+ *
+ * A helper thread repeatedly posts a ping to the main thread and waits for it to be handled.
+ * Whenever a ping takes longer than the threshold, the event loop was blocked: the helper
+ * samples the main thread's active trace zone (see TraceZone) while the stall lasts, and once
+ * the ping finally runs the stall is logged and added to a histogram. Must be created and
+ * started on the main thread.
+ */
+class StallWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs a stopped watchdog.
+     *
+     * @param thresholdMs Shortest event loop delay, in milliseconds, that counts as a stall.
+     * @param parent Parent QObject.
+     */
+    explicit StallWatchdog(int thresholdMs = 100, QObject *parent = nullptr);
+
+    /**
+     * @brief Stops the watchdog if it is still running.
+     */
+    ~StallWatchdog() override;
+
+    /**
+     * @brief Starts pinging the main event loop.
+     */
+    void start();
+
+    /**
+     * @brief Stops the helper thread; recorded stalls are kept.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the stall threshold in milliseconds.
+     */
+    int thresholdMs() const;
+
+    /**
+     * @brief Returns a copy of every stall recorded so far.
+     */
+    QVector<StallRecord> stalls() const;
+
+    /**
+     * @brief Formats the recorded stalls as a multi-line histogram with totals.
+     */
+    QString summary() const;
+
+private:
+    /**
+     * @brief Helper thread that sends the pings and samples the active zone.
+     */
+    class PingThread : public QThread
+    {
+    public:
+        explicit PingThread(StallWatchdog *watchdog) : m_watchdog(watchdog) {}
+
+    protected:
+        void run() override;
+
+    private:
+        StallWatchdog *m_watchdog;
+    };
+
+    /// Handles a ping on the main thread and records a stall if it arrived late.
+    void handlePing(quint64 sequence);
+
+    int m_thresholdMs;                          ///< Stall threshold in milliseconds.
+    PingThread m_thread;                        ///< Helper thread.
+    QElapsedTimer m_clock;                      ///< Time base shared by both threads.
+    std::atomic<bool> m_stopping{false};        ///< Set to end the helper thread.
+    std::atomic<quint64> m_sentSequence{0};     ///< Sequence number of the last ping sent.
+    std::atomic<quint64> m_handledSequence{0};  ///< Sequence number of the last ping handled.
+    std::atomic<qint64> m_sentAtNs{0};          ///< Time the last ping was sent.
+
+    mutable QMutex m_mutex;                     ///< Guards the members below.
+    QStringList m_currentZones;                 ///< Zones sampled during the ongoing stall.
+    QVector<StallRecord> m_stalls;              ///< Stalls recorded so far.
+};
+
+#endif // STALL_WATCHDOG_H
@@ -0,0 +1,166 @@
+#include "trace.h"
+#include "perf_counters.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QVector>
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char* name;
+        qint64 startNs;
+        qint64 durationNs;
+        qint64 bytes;
+        qint64 items;
+        int thread;
+    };
+
+    QMutex eventsMutex;
+    QVector<TraceEvent> events;
+    qint64 recordingOriginNs = 0;
+    std::atomic<int> nextThread{0};
+    thread_local bool trackedThread = false;
+
+    // Monotonic clock shared by recording and counting, started on first use
+    const QElapsedTimer& sharedClock()
+    {
+        static const QElapsedTimer clock = [] {
+            QElapsedTimer timer;
+            timer.start();
+            return timer;
+        }();
+        return clock;
+    }
+
+    // Small sequential thread ids read better in the viewer than native handles
+    int currentThread()
+    {
+        thread_local int id = nextThread.fetch_add(1);
+        return id;
+    }
+}
+
+std::atomic<unsigned> Trace::mode{0};
+std::atomic<const char*> Trace::activeZone{nullptr};
+
+void Trace::start()
+{
+    QMutexLocker locker(&eventsMutex);
+
+    events.clear();
+    recordingOriginNs = now();
+    mode.fetch_or(Recording, std::memory_order_relaxed);
+}
+
+void Trace::stop()
+{
+    mode.fetch_and(~unsigned(Recording), std::memory_order_relaxed);
+}
+
+void Trace::setMainThreadTracking(bool enabled)
+{
+    trackedThread = enabled;
+    activeZone.store(nullptr, std::memory_order_relaxed);
+
+    if (enabled)
+        mode.fetch_or(TrackingMainThread, std::memory_order_relaxed);
+    else
+        mode.fetch_and(~unsigned(TrackingMainThread), std::memory_order_relaxed);
+}
+
+bool Trace::isTrackedThread()
+{
+    return trackedThread;
+}
+
+void Trace::setCounting(bool enabled)
+{
+    if (enabled)
+        mode.fetch_or(Counting, std::memory_order_relaxed);
+    else
+        mode.fetch_and(~unsigned(Counting), std::memory_order_relaxed);
+}
+
+qint64 Trace::now()
+{
+    return sharedClock().nsecsElapsed();
+}
+
+void Trace::record(const char* name, qint64 startNs, qint64 durationNs, qint64 bytes, qint64 items)
+{
+    unsigned current = mode.load(std::memory_order_relaxed);
+
+    if (current & Counting)
+        PerfCounters::addZone(name, durationNs, bytes, items);
+
+    if (!(current & Recording))
+        return;
+
+    int thread = currentThread();
+
+    QMutexLocker locker(&eventsMutex);
+    events.append({name, startNs, durationNs, bytes, items, thread});
+}
+
+bool Trace::writeChromeTrace(const QString& filename)
+{
+    QJsonArray traceEvents;
+    QVector<TraceEvent> snapshot;
+    qint64 originNs;
+
+    {
+        QMutexLocker locker(&eventsMutex);
+        snapshot = events;
+        originNs = recordingOriginNs;
+    }
+
+    // Trace-event timestamps and durations are in microseconds
+    for (const TraceEvent& event : snapshot) {
+        QJsonObject slice;
+        slice["name"] = QString::fromLatin1(event.name);
+        slice["cat"] = "gdqt";
+        slice["ph"] = "X";
+        slice["ts"] = (event.startNs - originNs) / 1000.0;
+        slice["dur"] = event.durationNs / 1000.0;
+        slice["pid"] = 1;
+        slice["tid"] = event.thread;
+
+        QJsonObject args;
+        if (event.bytes >= 0)
+            args["bytes"] = event.bytes;
+        if (event.items >= 0)
+            args["items"] = event.items;
+        if (!args.isEmpty())
+            slice["args"] = args;
+
+        traceEvents.append(slice);
+    }
+
+    // Name the process so it is recognizable in the viewer
+    QJsonObject processName;
+    processName["name"] = "process_name";
+    processName["ph"] = "M";
+    processName["pid"] = 1;
+    processName["args"] = QJsonObject{{"name", "GDQT"}};
+    traceEvents.append(processName);
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Could not open trace file for writing:" << filename;
+        return false;
+    }
+
+    QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    return file.write(json) == json.size();
+}
@@ -0,0 +1,163 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+
+/**
+ * @brief Lightweight recorder of timed zones, exported in the Chrome trace-event format.
+ *
+ * Recording is off by default; every zone then costs a single relaxed atomic load. Once
+ * @ref Trace::start is called, completed zones are collected in memory and
+ * @ref Trace::writeChromeTrace saves them as a JSON file that can be opened in Perfetto
+ * (ui.perfetto.dev) or chrome://tracing.
+ *
+ * Independently of recording, the innermost zone open on the main thread can be published
+ * through @ref Trace::activeZone, so that other threads (such as the stall watchdog) can tell
+ * what the GUI thread is busy with.
+ */
+namespace Trace
+{
+    /// Bits of @ref mode.
+    enum Mode : unsigned
+    {
+        /// Completed zones are recorded for the trace file.
+        Recording = 1,
+        /// The innermost zone of the main thread is published in @ref activeZone.
+        TrackingMainThread = 2,
+        /// Completed zones are added to PerfCounters.
+        Counting = 4
+    };
+
+    /// Combination of Mode bits; 0 when tracing is completely off.
+    extern std::atomic<unsigned> mode;
+
+    /// Name of the innermost zone open on the main thread, or nullptr; kept while TrackingMainThread is set.
+    extern std::atomic<const char*> activeZone;
+
+    /**
+     * @brief Checks whether zones are currently recorded.
+     */
+    inline bool isEnabled() { return mode.load(std::memory_order_relaxed) & Recording; }
+
+    /**
+     * @brief Starts or stops publishing the main thread's innermost zone in @ref activeZone.
+     *
+     * Must be called from the main thread, which becomes the tracked thread.
+     *
+     * @param enabled Whether to track the main thread's zones.
+     */
+    void setMainThreadTracking(bool enabled);
+
+    /**
+     * @brief Checks whether the calling thread is the thread passed to @ref setMainThreadTracking.
+     */
+    bool isTrackedThread();
+
+    /**
+     * @brief Starts or stops adding completed zones to PerfCounters.
+     */
+    void setCounting(bool enabled);
+
+    /**
+     * @brief Starts recording zones, discarding anything recorded before.
+     */
+    void start();
+
+    /**
+     * @brief Stops recording zones; recorded zones are kept until the next @ref start.
+     */
+    void stop();
+
+    /**
+     * @brief Writes the recorded zones as a Chrome trace-event JSON file.
+     *
+     * @param filename The path of the file to create or overwrite.
+     * @return True if the file was written successfully; otherwise false.
+     */
+    bool writeChromeTrace(const QString& filename);
+
+    /**
+     * @brief Records a completed zone in the trace and/or the performance counters.
+     *
+     * @param name Zone name; must point to a string literal or other static storage.
+     * @param startNs Start time as returned by @ref now.
+     * @param durationNs Duration in nanoseconds.
+     * @param bytes Bytes processed within the zone, or -1 if not applicable.
+     * @param items Items processed within the zone, or -1 if not applicable.
+     */
+    void record(const char* name, qint64 startNs, qint64 durationNs, qint64 bytes, qint64 items);
+
+    /**
+     * @brief Returns the current time in nanoseconds on the clock shared by all zones.
+     */
+    qint64 now();
+}
+
+/**
+ * @brief Times the enclosing scope and records it as a trace zone.
+ *
+ * Does nothing beyond checking @ref Trace::isEnabled when recording is off. The bytes and item
+ * counts set on the zone are shown as arguments of the slice in the trace viewer.
+ */
+class TraceZone
+{
+public:
+    /**
+     * @brief Opens a zone.
+     *
+     * @param name Zone name; must point to a string literal or other static storage.
+     */
+    explicit TraceZone(const char* name)
+        : name(name)
+        , mode(Trace::mode.load(std::memory_order_relaxed))
+    {
+        if (mode == 0)
+            return;
+
+        if (mode & (Trace::Recording | Trace::Counting))
+            startNs = Trace::now();
+
+        // Publish this zone as the main thread's innermost one, remembering the enclosing zone
+        if ((mode & Trace::TrackingMainThread) && Trace::isTrackedThread()) {
+            previousZone = Trace::activeZone.exchange(name, std::memory_order_relaxed);
+            published = true;
+        }
+    }
+
+    /**
+     * @brief Closes the zone and records it if recording or counting was on when it was opened.
+     */
+    ~TraceZone()
+    {
+        if (mode == 0)
+            return;
+
+        if (mode & (Trace::Recording | Trace::Counting))
+            Trace::record(name, startNs, Trace::now() - startNs, bytes, items);
+
+        if (published)
+            Trace::activeZone.store(previousZone, std::memory_order_relaxed);
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+    /// Sets the number of bytes processed within the zone.
+    void setBytes(qint64 count) { bytes = count; }
+    /// Sets the number of items (files, quests, rows...) processed within the zone.
+    void setItems(qint64 count) { items = count; }
+
+private:
+    const char* name;                   ///< Zone name.
+    unsigned mode;                      ///< Trace::mode when the zone was opened.
+    bool published = false;             ///< Whether the zone was published as the active zone.
+    const char* previousZone = nullptr; ///< Active zone to restore on destruction.
+    qint64 startNs = 0;                 ///< Start time as returned by Trace::now.
+    qint64 bytes = -1;                  ///< Bytes processed, or -1 if not set.
+    qint64 items = -1;                  ///< Items processed, or -1 if not set.
+};
+
+#endif // TRACE_H
@@ -8,86 +8,18 @@
 #include <QApplication>
 #include <QStyleFactory>
 
-// Difficluty
+#include "quest_types.h"
 
-enum class DifficultyLevel {
-    Normal,
-    Elite,
-    Ultimate
-};
-
-struct Difficulty {
-    DifficultyLevel level;
-    QString name;
-
-    Difficulty(DifficultyLevel lvl, const QString &nm) : level(lvl), name(nm) {}
+// Quest status colors
 
-    static QList<Difficulty> getAllDifficulties() {
-        return {
-            {DifficultyLevel::Normal, "Normal"},
-            {DifficultyLevel::Elite, "Elite"},
-            {DifficultyLevel::Ultimate, "Ultimate"}
-        };
+inline QColor QuestStatus::color() const {
+    switch (status) {
+    case NotCompleted: return QColor(244, 67, 54);
+    case InProgress: return QColor(0, 176, 255);
+    case Completed: return QColor(76, 175, 80);
+    default: return QColor(0, 0, 0);
     }
-};
-
-// Quests
-
-struct QuestInfo
-{
-    QString Chapter;
-    QString QuestName;
-};
-
-struct QuestStatus {
-    enum Status {
-        NotCompleted,
-        InProgress,
-        Completed
-    };
-
-    Status status;
-
-    QuestStatus(Status s = NotCompleted) : status(s) {}
-
-    QString toString() const {
-        switch (status) {
-        case NotCompleted: return "Not completed";
-        case InProgress: return "In Progress";
-        case Completed: return "Completed";
-        default: return "Unknown";
-        }
-    }
-
-    QColor color() const {
-        switch (status) {
-        case NotCompleted: return QColor(244, 67, 54);
-        case InProgress: return QColor(0, 176, 255);
-        case Completed: return QColor(76, 175, 80);
-        default: return QColor(0, 0, 0);
-        }
-    }
-};
-
-class QuestData {
-public:
-    void setStatus(const QString &chapter, const QString &quest, const QString &difficulty, QuestStatus::Status status) {
-        data[chapter][quest][difficulty] = QuestStatus(status);
-    }
-
-    QuestStatus getStatus(const QString &chapter, const QString &quest, const QString &difficulty) const {
-        return data.value(chapter).value(quest).value(difficulty, QuestStatus(QuestStatus::NotCompleted));
-    }
-
-    // Итераторы для удобного доступа к данным (если нужно)
-    auto chapters() const { return data.keys(); }
-    auto quests(const QString &chapter) const { return data.value(chapter).keys(); }
-    auto difficulties(const QString &chapter, const QString &quest) const { return data.value(chapter).value(quest).keys(); }
-    auto allData() const { return data; }
-
-private:
-    QMap<QString, QMap<QString, QMap<QString, QuestStatus>>> data;
-};
+}
 
 // Themes
 
@@ -1,90 +1,493 @@
 #include "utils.h"
 #include "qst_parser.h"
+#include "trace.h"
+#include "alloc_stats.h"
+#include "perf_counters.h"
+#include "arc_archive.h"
+#include "json_writer.h"
+#include "quest_catalog.h"
 
 #include <QDir>
 #include <QFile>
 #include <QJsonDocument>
+#include <QJsonArray>
 #include <QJsonObject>
 #include <QMap>
 #include <QRegularExpression>
 #include <QDirIterator>
 #include <QDebug>
+#include <QException>
+#include <QThread>
+#include <QtConcurrent>
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QSaveFile>
 
-bool generateQuestJson(const QString &inputDirectoryPath)
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace
 {
-    // Define the output file path where the JSON data will be saved
-    QString outputFilePath = QDir::currentPath() + "/resources/quests.json";
-    QMap<QString, QstFile> questData;
-    QDir dir(inputDirectoryPath);
+    // Bump when the parser output changes, so stale manifests are ignored
+    constexpr int manifestVersion = 4;
 
-    // Check if the input directory exists
-    if (!dir.exists()) {
-        qWarning() << "Directory does not exist:" << inputDirectoryPath;
-        return false;
+    /**
+     * @brief What is known about one .qst file, as stored in the manifest.
+     */
+    struct QstRecord
+    {
+        qint64 size = -1;
+        qint64 modified = 0;
+        QByteArray contentHash;
+        bool ok = false;
+        quint32 questHash = 0;
+        QString chapter;
+        QString quest;
+        /// Names in languages other than English, keyed by locale tag.
+        QMap<QString, QstLocalization> localized;
+        /// Set if the names were found by the marker scan rather than read from a localization record.
+        bool scanned = false;
+        /// Set if the file was parsed in this run rather than taken from the manifest.
+        bool reparsed = false;
+    };
+
+    /**
+     * @brief A .qst file that is new or whose size or modification time changed.
+     */
+    struct QstTask
+    {
+        /// Path on disk, or the entry name for archive members.
+        QString path;
+        qint64 size = 0;
+        qint64 modified = 0;
+        /// Archive holding the file and its entry index, or null for files on disk.
+        const ArcArchive *archive = nullptr;
+        int entryIndex = -1;
+        /// Manifest record of the file, if it had one; reused if the contents did not change.
+        std::optional<QstRecord> previous;
+    };
+
+    // Runs on a worker thread: reuses the previous record if only the timestamp changed, else parses
+    QstRecord processQstTask(const QstTask &task)
+    {
+        QstRecord record;
+        record.size = task.size;
+        record.modified = task.modified;
+        record.reparsed = true;
+
+        // Archive members are decompressed in memory; files on disk are mapped while they are processed
+        QFile file(task.path);
+        QByteArray contents;
+        if (task.archive) {
+            try {
+                contents = task.archive->extract(task.archive->entries().at(task.entryIndex));
+            } catch (const QException &) {
+                qWarning() << "Corrupt archive entry:" << task.path;
+                return record;
+            }
+        } else if (file.open(QIODevice::ReadOnly) && file.size() <= QstFile::maxFileSize) {
+            const uchar *mapped = file.size() > 0 ? file.map(0, file.size()) : nullptr;
+            contents = mapped ? QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), int(file.size())) : file.readAll();
+        } else {
+            qWarning() << "Could not read file:" << task.path;
+            return record;
+        }
+
+        record.contentHash = QCryptographicHash::hash(contents, QCryptographicHash::Md5).toHex();
+
+        if (task.previous && record.contentHash == task.previous->contentHash) {
+            record = *task.previous;
+            record.size = task.size;
+            record.modified = task.modified;
+            return record;
+        }
+
+        QstFile qstFile(task.path);
+        record.ok = qstFile.parse(contents);
+        if (record.ok) {
+            record.questHash = qstFile.getQuestHash();
+            record.chapter = qstFile.getChapterName();
+            record.quest = qstFile.getQuestName();
+            record.localized = qstFile.getLocalizations();
+            record.localized.remove("enUS");
+            record.scanned = qstFile.usedScanFallback();
+        }
+
+        return record;
+    }
+
+    QString manifestPath(const QString &outputFilePath)
+    {
+        return outputFilePath + ".manifest";
+    }
+
+    // Reads the manifest written next to the output; missing or outdated manifests read as empty
+    QHash<QString, QstRecord> readManifest(const QString &path)
+    {
+        QHash<QString, QstRecord> records;
+
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return records;
+
+        const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+        if (root.value("version").toInt() != manifestVersion)
+            return records;
+
+        const QJsonObject files = root.value("files").toObject();
+        records.reserve(files.size());
+
+        for (auto it = files.begin(); it != files.end(); ++it) {
+            const QJsonObject entry = it.value().toObject();
+
+            QstRecord record;
+            record.size = qint64(entry.value("size").toDouble(-1));
+            record.modified = qint64(entry.value("modified").toDouble());
+            record.contentHash = entry.value("md5").toString().toLatin1();
+            record.ok = entry.value("ok").toBool();
+            record.questHash = entry.value("hash").toString().toUInt(nullptr, 0);
+            record.chapter = entry.value("chapter").toString();
+            record.quest = entry.value("quest").toString();
+            record.scanned = entry.value("scanned").toBool();
+
+            const QJsonObject localized = entry.value("localized").toObject();
+            for (auto locale = localized.begin(); locale != localized.end(); ++locale) {
+                const QJsonArray names = locale.value().toArray();
+                record.localized.insert(locale.key(), {names.at(0).toString(), names.at(1).toString()});
+            }
+            records.insert(it.key(), record);
+        }
+
+        return records;
+    }
+
+    bool writeManifest(const QString &path, const QStringList &keys, const QVector<QstRecord> &records)
+    {
+        QJsonObject files;
+        for (int i = 0; i < keys.size(); i++) {
+            const QstRecord &record = records[i];
+
+            QJsonObject entry;
+            entry["size"] = double(record.size);
+            entry["modified"] = double(record.modified);
+            entry["md5"] = QString::fromLatin1(record.contentHash);
+            entry["ok"] = record.ok;
+            if (record.ok) {
+                entry["hash"] = QString("0x%1").arg(record.questHash, 8, 16, QChar('0'));
+                entry["chapter"] = record.chapter;
+                entry["quest"] = record.quest;
+                if (record.scanned)
+                    entry["scanned"] = true;
+
+                QJsonObject localized;
+                for (auto locale = record.localized.cbegin(); locale != record.localized.cend(); ++locale)
+                    localized[locale.key()] = QJsonArray{locale->chapterName, locale->questName};
+                if (!localized.isEmpty())
+                    entry["localized"] = localized;
+            }
+            files[keys[i]] = entry;
+        }
+
+        QJsonObject root;
+        root["version"] = manifestVersion;
+        root["files"] = files;
+
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        return file.commit();
     }
+}
 
-    // Initialize an iterator to traverse all .qst files in subdirectories
-    // QDirIterator::Subdirectories flag ensures recursive search
-    QDirIterator it(inputDirectoryPath, QStringList() << "*.qst", QDir::Files, QDirIterator::Subdirectories);
+bool generateQuestJson(const QString &inputDirectoryPath, const QString &outputFilePathOverride, const QuestJsonProgress &progress)
+{
+    TraceZone zone("generateQuestJson");
+    AllocScope allocScope("generateQuestJson");
+
+    // Define the output file path where the JSON data will be saved
+    QString outputFilePath = outputFilePathOverride.isEmpty() ? QDir::currentPath() + "/resources/quests.json" : outputFilePathOverride;
+    QMap<QString, QstRecord> questData;
     QStringList questFiles;
+    QVector<QstTask> sources;
+
+    // The input is a Quests.arc archive or a folder searched for .qst files and Quests.arc archives,
+    // so the Grim Dawn install folder (base game and expansions) can be used without extracting
+    std::vector<std::unique_ptr<ArcArchive>> archives;
+    QStringList archivePaths;
+
+    auto addArchive = [&](const QString &archivePath) {
+        auto archive = std::make_unique<ArcArchive>();
+        try {
+            archive->open(archivePath);
+        } catch (const QException &) {
+            qWarning() << "Could not read archive:" << archivePath;
+            return false;
+        }
+
+        const QVector<ArcEntry> &entries = archive->entries();
+        for (int i = 0; i < entries.size(); i++) {
+            const ArcEntry &entry = entries[i];
+            if (!entry.name.endsWith(".qst", Qt::CaseInsensitive))
+                continue;
+
+            if (entry.decompressedSize > QstFile::maxFileSize) {
+                qWarning() << "File too large to be a quest file:" << entry.name;
+                continue;
+            }
+
+            QstTask source;
+            source.path = entry.name;
+            source.size = entry.decompressedSize;
+            source.modified = qint64(entry.fileTime);
+            source.archive = archive.get();
+            source.entryIndex = i;
+            sources.append(source);
+            archivePaths.append(archivePath);
+        }
+
+        archives.push_back(std::move(archive));
+        return true;
+    };
+
+    QFileInfo inputInfo(inputDirectoryPath);
 
-    // Collect all .qst file paths into a list for processing
-    while (it.hasNext()) {
-        questFiles.append(it.next());
+    if (inputInfo.isFile()) {
+        if (!addArchive(inputDirectoryPath))
+            return false;
+    } else {
+        QDir dir(inputDirectoryPath);
+
+        // Check if the input directory exists
+        if (!dir.exists()) {
+            qWarning() << "Directory does not exist:" << inputDirectoryPath;
+            return false;
+        }
+
+        // Initialize an iterator to traverse all .qst files and archives in subdirectories
+        // QDirIterator::Subdirectories flag ensures recursive search
+        QDirIterator it(inputDirectoryPath, QStringList() << "*.qst" << "*.arc", QDir::Files, QDirIterator::Subdirectories);
+
+        // Collect all .qst file paths into a list for processing
+        while (it.hasNext()) {
+            const QString filePath = it.next();
+
+            if (it.fileInfo().suffix().compare("arc", Qt::CaseInsensitive) == 0) {
+                if (it.fileInfo().completeBaseName().compare("quests", Qt::CaseInsensitive) == 0)
+                    addArchive(filePath);
+                continue;
+            }
+
+            QstTask source;
+            source.path = filePath;
+            source.size = it.fileInfo().size();
+            source.modified = it.fileInfo().lastModified().toMSecsSinceEpoch();
+            sources.append(source);
+            archivePaths.append(QString());
+        }
     }
 
-    qDebug() << "Found" << questFiles.size() << ".qst files in directory:" << inputDirectoryPath;
+    // Files whose size and modification time match the manifest are not opened again
+    const QHash<QString, QstRecord> manifest = readManifest(manifestPath(outputFilePath));
+    const QDir inputDir(inputInfo.isFile() ? inputInfo.absolutePath() : inputDirectoryPath);
+    QStringList manifestKeys;
+    QVector<QstRecord> records;
+    QVector<QstTask> tasks;
+    QVector<int> taskIndexes;
+    int knownFiles = 0;
+
+    for (int i = 0; i < sources.size(); i++) {
+        QstTask &source = sources[i];
+
+        // Archive members are keyed by archive and entry name, as the expansions reuse entry names
+        const QString key = source.archive ? inputDir.relativeFilePath(archivePaths[i]) + ":" + source.path
+                                           : inputDir.relativeFilePath(source.path);
+
+        QstRecord record;
+        auto known = manifest.constFind(key);
+        if (known != manifest.constEnd()) {
+            knownFiles++;
+            if (known->size == source.size && known->modified == source.modified) {
+                record = known.value();
+            } else {
+                source.previous = known.value();
+            }
+        }
+
+        if (record.size < 0) {
+            taskIndexes.append(records.size());
+            tasks.append(source);
+        }
+
+        questFiles.append(source.path);
+        manifestKeys.append(key);
+        records.append(record);
+    }
+
+    qDebug() << "Found" << questFiles.size() << ".qst files in" << inputDirectoryPath << "-" << archives.size() << "archives,"
+             << tasks.size() << "new or modified," << manifest.size() - knownFiles << "removed";
 
     // If no .qst files are found, log a warning and exit
     if (questFiles.isEmpty()) {
-        qWarning() << "No .qst files found in directory:" << inputDirectoryPath;
+        qWarning() << "No .qst files found in:" << inputDirectoryPath;
         return false;
     }
 
-    // Parse each .qst file and extract quest data
-    for (const QString &filePath : questFiles) {
-        QstFile qstFile(filePath);
-        if (qstFile.parse()) {
-            // Obtain the quest hash and format it as a hexadecimal string with leading zeros
-            // This serves as a unique identifier for each quest
-            QString questIdStr = QString("0x%1").arg(qstFile.getQuestHash(), 8, 16, QChar('0'));
-
-            // Store the parsed quest data in a map with the quest ID as the key
-            questData[questIdStr] = qstFile;
-            qDebug() << "Added quest:" << questIdStr << "Chapter:" << qstFile.getChapterName() << "Quest:" << qstFile.getQuestName();
+    zone.setItems(questFiles.size());
+
+    // Process the new and modified files on the thread pool; the results keep the order of tasks
+    {
+        TraceZone parseZone("generateQuestJson/parse");
+        parseZone.setItems(tasks.size());
+
+        QFuture<QstRecord> future = QtConcurrent::mapped(tasks, processQstTask);
+
+        PerfCounters::setGauge("QST worker queue depth", tasks.size());
+
+        // Poll for progress so the caller can update its display and cancel
+        while (progress && !future.isFinished()) {
+            int parsed = future.progressValue();
+            PerfCounters::setGauge("QST worker queue depth", tasks.size() - parsed);
+
+            if (!progress(parsed, tasks.size())) {
+                future.cancel();
+                future.waitForFinished();
+                PerfCounters::setGauge("QST worker queue depth", 0);
+                qInfo() << "Quest data generation was cancelled.";
+                return false;
+            }
+
+            QThread::msleep(15);
+        }
+
+        future.waitForFinished();
+        PerfCounters::setGauge("QST worker queue depth", 0);
+
+        const QList<QstRecord> results = future.results();
+        for (int i = 0; i < results.size(); i++)
+            records[taskIndexes[i]] = results[i];
+    }
+
+    if (progress)
+        progress(tasks.size(), tasks.size());
+
+    // Merge in directory order, so the last file wins for a duplicate hash exactly as in a serial scan
+    int collisions = 0;
+    int reparsed = 0;
+    int scanned = 0;
+    for (const QstRecord &record : std::as_const(records)) {
+        if (record.reparsed)
+            reparsed++;
+        if (!record.ok)
+            continue;
+        if (record.scanned)
+            scanned++;
+
+        // Obtain the quest hash and format it as a hexadecimal string with leading zeros
+        // This serves as a unique identifier for each quest
+        QString questIdStr = QString("0x%1").arg(record.questHash, 8, 16, QChar('0'));
+
+        auto existing = questData.constFind(questIdStr);
+        if (existing != questData.constEnd() && (existing->chapter != record.chapter || existing->quest != record.quest)) {
+            qWarning() << "Quest hash collision:" << questIdStr << existing->quest << "replaced by" << record.quest;
+            collisions++;
         }
+
+        // Store the parsed quest data in a map with the quest ID as the key
+        questData[questIdStr] = record;
     }
 
+    qDebug() << "Parsed" << reparsed << "files," << questData.size() << "quests," << collisions << "hash collisions,"
+             << scanned << "names found by scanning.";
+    if (scanned > 0)
+        qWarning() << scanned << "quest files have no localization record; their names were found by scanning and may be inaccurate.";
+
     // If no quest data was parsed successfully, log a warning and exit
     if (questData.isEmpty()) {
         qWarning() << "No quest data was parsed. JSON will be empty.";
         return false;
     }
 
-    QJsonObject jsonObject;
+    // Nothing to rewrite if no file was added, removed or changed in content since the last run,
+    // unless the catalog is missing, of an older format or not written with this quests.json
+    const QString catalogPath = QuestCatalog::pathFor(outputFilePath);
+    QuestCatalog currentCatalog;
+    if (reparsed == 0 && knownFiles == manifest.size() && QFile::exists(outputFilePath) && currentCatalog.open(catalogPath, outputFilePath)) {
+        if (!tasks.isEmpty())
+            writeManifest(manifestPath(outputFilePath), manifestKeys, records);
 
-    // Convert the quest data into a JSON object
-    for (auto it = questData.begin(); it != questData.end(); ++it) {
-        QJsonObject questObj;
-        // Add the chapter name and quest name to the JSON object
-        questObj["Chapter"] = it.value().getChapterName();
-        questObj["QuestName"] = it.value().getQuestName();
-
-        // Use the quest ID as the key in the JSON object
-        jsonObject[it.key()] = questObj;
+        qDebug() << "Quest data in" << outputFilePath << "is up to date with" << questData.size() << "entries.";
+        return true;
     }
 
-    // Open the output file for writing, truncating it if it already exists
-    QFile outputFile(outputFilePath);
-    if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    // Write to a temporary file that replaces the output only once complete
+    QSaveFile outputFile(outputFilePath);
+    if (!outputFile.open(QIODevice::WriteOnly)) {
         qWarning() << "Could not open output file for writing:" << outputFilePath;
         return false;
     }
 
-    // Write the JSON data to the file with indentation for readability
-    QJsonDocument jsonDoc(jsonObject);
-    outputFile.write(jsonDoc.toJson(QJsonDocument::Indented));
-    outputFile.close();
+    // Stream the quests in key order, in the same indented layout QJsonDocument would produce
+    TraceZone writeZone("generateQuestJson/write");
+    JsonStreamWriter writer(&outputFile);
+
+    writer.beginObject();
+    for (auto it = questData.cbegin(); it != questData.cend(); ++it) {
+        // Use the quest ID as the key, with the chapter name and quest name as members
+        writer.writeKey(it.key());
+        writer.beginObject();
+        writer.writeKey("Chapter");
+        writer.writeString(it.value().chapter);
+
+        // Other languages are only written if the files have them, so English-only data is unchanged
+        if (!it.value().localized.isEmpty()) {
+            writer.writeKey("Localized");
+            writer.beginObject();
+            for (auto locale = it.value().localized.cbegin(); locale != it.value().localized.cend(); ++locale) {
+                writer.writeKey(locale.key());
+                writer.beginObject();
+                writer.writeKey("Chapter");
+                writer.writeString(locale->chapterName);
+                writer.writeKey("QuestName");
+                writer.writeString(locale->questName);
+                writer.endObject();
+            }
+            writer.endObject();
+        }
+
+        writer.writeKey("QuestName");
+        writer.writeString(it.value().quest);
+        writer.endObject();
+    }
+    writer.endObject();
+
+    if (!writer.ok() || !outputFile.commit()) {
+        qWarning() << "Could not write output file:" << outputFilePath;
+        return false;
+    }
+
+    writeZone.setBytes(writer.bytesWritten());
+    writeZone.setItems(questData.size());
+
+    // The binary catalog next to the JSON lets the tracker map the quest data instead of parsing it
+    QMap<quint32, QuestInfo> catalogQuests;
+    for (const QstRecord &record : std::as_const(questData)) {
+        QuestInfo &info = catalogQuests[record.questHash];
+        info.Chapter = record.chapter;
+        info.QuestName = record.quest;
+        for (auto locale = record.localized.cbegin(); locale != record.localized.cend(); ++locale)
+            info.Localized.insert(locale.key(), LocalizedNames{locale->chapterName, locale->questName});
+    }
+
+    // A catalog left from an older JSON would be rejected by its checksum anyway; do not keep it around
+    if (!QuestCatalog::write(catalogPath, catalogQuests, writer.bytesWritten(), writer.md5()))
+        QFile::remove(catalogPath);
+
+    // Remember what was parsed, so the next run only looks at what changed
+    if (!writeManifest(manifestPath(outputFilePath), manifestKeys, records))
+        qWarning() << "Could not write the QST manifest next to" << outputFilePath;
 
     qDebug() << "Quest data saved to" << outputFilePath << "successfully with" << questData.size() << "entries.";
 
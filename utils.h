@@ -4,17 +4,33 @@
 #include <QString>
 #include <QMap>
 
+#include <functional>
+
+/**
+ * @brief Reports the progress of generateQuestJson.
+ *
+ * Called on the calling thread with the number of parsed and found .qst files; returning false
+ * cancels the generation.
+ */
+using QuestJsonProgress = std::function<bool(int parsed, int total)>;
+
 /**
  * @brief Generates a JSON file containing quest data from .qst files in the specified directory.
  *
- * This function recursively searches for all .qst files in the given directory,
- * parses each file to extract quest information, and saves the collected data
- * in a JSON file at the path `resources/quests.json`. Each quest is uniquely identified
+ * This function recursively searches for all .qst files in the given directory, including those
+ * inside Quests.arc archives (read directly, see ArcArchive),
+ * parses the files on the global thread pool to extract quest information, and saves the collected data
+ * in a JSON file, by default at the path `resources/quests.json`. Each quest is uniquely identified
  * by a hash, and the JSON data includes both the chapter name and quest name for each entry.
+ * The output does not depend on the number of threads: if several files share a hash, the
+ * last one in directory order wins, and a warning is logged if their names differ.
  *
- * @param inputDirectoryPath The directory to search for .qst files.
- * @return True if the JSON file was generated successfully; otherwise, false.
+ * @param inputDirectoryPath The directory to search for .qst files and Quests.arc archives, or one .arc archive.
+ * @param outputFilePath The JSON file to write; empty for `resources/quests.json` in the current directory.
+ * @param progress Optional progress callback, polled while the files are parsed.
+ * @return True if the JSON file was generated successfully; false on failure or cancellation.
  */
-bool generateQuestJson(const QString &inputDirectoryPath);
+bool generateQuestJson(const QString &inputDirectoryPath, const QString &outputFilePath = QString(),
+                       const QuestJsonProgress &progress = QuestJsonProgress());
 
 #endif // UTILS_H